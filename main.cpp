@@ -1,11 +1,29 @@
 #include <iostream>
-#include <fstream>
-#include <sstream>
 #include <string>
+#include <cstring>
 #include <climits>
+#include <cstdint>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 using namespace std;
 
-const int sizeX = 26; // sizeX of the hash table.
+const uint32_t NO_NODE = UINT32_MAX; // Index used when an intersection is unknown or has no predecessor.
+const int hashInitialCapacity = 16; // Starting number of slots of a hash table, always a power of two.
+const int hashMaxLoadPercent = 75;  // Live entries plus tombstones allowed before a rehash.
 
 template <typename T>
 class Node {
@@ -21,8 +39,8 @@ class HashTableNode {
 public:
     string key;
     T data;
-    bool occupied;
-    HashTableNode(string key = "") : key(key), data(T()), occupied(false) {}
+    uint64_t hash;
+    HashTableNode(string key = "", T data = T(), uint64_t hash = 0) : key(key), data(data), hash(hash) {}
 };
 
 template <typename T>
@@ -34,22 +52,22 @@ public:
     MinHeapNode(T id = T(), int priority = INT_MAX)
         : id(id), priority(priority) {}
 
-    bool operator<(MinHeapNode a) {
+    bool operator<(const MinHeapNode& a) const {
         return priority < a.priority;
     }
 
-    bool operator>(MinHeapNode a) {
+    bool operator>(const MinHeapNode& a) const {
         return priority > a.priority;
     }
 };
 
 class Edge {
 public:
-    string destination;
+    uint32_t destination;  // Dense index of the intersection this road leads to.
     int weight;
     int vehicles;
     bool blocked;
-    Edge(const string& destination = "", int weight = 0, int vehicles = 0)
+    Edge(uint32_t destination = NO_NODE, int weight = 0, int vehicles = 0)
         : destination(destination), weight(weight), vehicles(vehicles), blocked(false) {}
 
     void block() { blocked = true; }
@@ -59,9 +77,9 @@ public:
 class Vehicles {
 public:
     string id;
-    string start;
-    string end;
-    Vehicles(string id = "", string start = "", string end = "") : id(id), start(start), end(end) {}
+    uint32_t start;  // Dense intersection indices, see Graph::indexOf.
+    uint32_t end;
+    Vehicles(string id = "", uint32_t start = NO_NODE, uint32_t end = NO_NODE) : id(id), start(start), end(end) {}
     operator string() {
         if (id.empty())
             return "";
@@ -69,6 +87,133 @@ public:
     }
 };
 
+template <typename T>
+class DynamicArray {
+public:
+    T* items;
+    int count;
+    int capacity;
+
+    DynamicArray() : items(nullptr), count(0), capacity(0) {}
+
+    DynamicArray(int n, T value = T()) : items(nullptr), count(0), capacity(0) {
+        resize(n, value);
+    }
+
+    DynamicArray(const DynamicArray<T>& other) : items(nullptr), count(0), capacity(0) {
+        reserve(other.count);
+        for (int i = 0; i < other.count; ++i) {
+            items[i] = other.items[i];
+        }
+        count = other.count;
+    }
+
+    DynamicArray(DynamicArray<T>&& other) : items(other.items), count(other.count), capacity(other.capacity) {
+        other.items = nullptr;
+        other.count = other.capacity = 0;
+    }
+
+    DynamicArray<T>& operator=(const DynamicArray<T>& other) {
+        if (this != &other) {
+            DynamicArray<T> copy(other);
+            swapWith(copy);
+        }
+        return *this;
+    }
+
+    DynamicArray<T>& operator=(DynamicArray<T>&& other) {
+        swapWith(other);
+        return *this;
+    }
+
+    ~DynamicArray() {
+        delete[] items;
+    }
+
+    // Exchanges the storage of two arrays without copying elements.
+    void swapWith(DynamicArray<T>& other) {
+        T* tempItems = items;
+        items = other.items;
+        other.items = tempItems;
+        int temp = count;
+        count = other.count;
+        other.count = temp;
+        temp = capacity;
+        capacity = other.capacity;
+        other.capacity = temp;
+    }
+
+    // Subscript operator overloading, no bounds checking.
+    T& operator[](int i) {
+        return items[i];
+    }
+
+    const T& operator[](int i) const {
+        return items[i];
+    }
+
+    // Grows the storage so that n elements fit without another allocation.
+    void reserve(int n) {
+        if (n <= capacity) {
+            return;
+        }
+        T* grown = new T[n];
+        for (int i = 0; i < count; ++i) {
+            grown[i] = std::move(items[i]);
+        }
+        delete[] items;
+        items = grown;
+        capacity = n;
+    }
+
+    // Changes the number of elements, filling new ones with value.
+    void resize(int n, T value = T()) {
+        reserve(n);
+        for (int i = count; i < n; ++i) {
+            items[i] = value;
+        }
+        count = n;
+    }
+
+    // Overwrites every element with value.
+    void fill(T value) {
+        for (int i = 0; i < count; ++i) {
+            items[i] = value;
+        }
+    }
+
+    // Appends an element, doubling the storage when it is full.
+    void pushBack(T value) {
+        if (count == capacity) {
+            reserve(capacity == 0 ? 4 : capacity * 2);
+        }
+        items[count++] = std::move(value);
+    }
+
+    // Removes and returns the last element.
+    T popBack() {
+        return std::move(items[--count]);
+    }
+
+    // Returns a reference to the last element.
+    T& back() {
+        return items[count - 1];
+    }
+
+    // Drops all elements but keeps the storage for reuse.
+    void clear() {
+        count = 0;
+    }
+
+    int size() const {
+        return count;
+    }
+
+    bool isEmpty() const {
+        return count == 0;
+    }
+};
+
 template <typename T>
 class LinkedList {
 
@@ -89,18 +234,6 @@ public:
         return copy;
     }
 
-    // Displays all neighbors of the graph.
-    void printList() {
-        Node<T>* current = head;
-        while (current) {
-            cout << "(" << current->data.destination << ", "
-                 << current->data.weight  << ")";
-            if (current->next) cout << " -> ";
-            current = current->next;
-        }
-        cout << endl;
-    }
-
     // Generic get function for heap operations
     T* getGeneric(string key) {
         Node<T>* current = head;
@@ -125,7 +258,7 @@ public:
     }
 
     // Meant for returning a pointer to an Edge object if the destination i.e 'from' is present.
-    T* get(string& value) {
+    T* get(uint32_t value) {
         Node<T>* current = head;
         while (current) {
             if (current->data.destination == value) {
@@ -214,7 +347,7 @@ public:
     }
 
     // Checks if an Edge's destination i.e 'from' is present.
-    bool contains(string& value) {
+    bool contains(uint32_t value) {
         Node<T>* current = head;
         while (current) {
             if (current->data.destination == value) {
@@ -238,156 +371,446 @@ public:
     }
 };
 
+// Read-only characters owned by someone else, such as a string or a mapped file. Lookups take
+// views so that a field of a loaded file can be found without copying it into a string.
+class StringView {
+public:
+    const char* data;
+    size_t length;
+
+    StringView() : data(""), length(0) {}
+    StringView(const char* data, size_t length) : data(data), length(length) {}
+    StringView(const char* text) : data(text), length(strlen(text)) {}
+    StringView(const string& text) : data(text.data()), length(text.size()) {}
+
+    bool empty() const {
+        return length == 0;
+    }
+
+    bool operator==(const StringView& other) const {
+        return length == other.length && memcmp(data, other.data, length) == 0;
+    }
+
+    string str() const {
+        return string(data, length);
+    }
+};
+
+// Parses a decimal int at the start of text the way stoi does: leading spaces, an optional
+// sign, then digits up to the first other character. Returns false instead of throwing if
+// there are no digits or the value doesn't fit.
+inline bool parseInt(StringView text, int& value) {
+    size_t i = 0;
+    while (i < text.length && (text.data[i] == ' ' || text.data[i] == '\t')) {
+        ++i;
+    }
+    bool negative = i < text.length && text.data[i] == '-';
+    if (i < text.length && (text.data[i] == '-' || text.data[i] == '+')) {
+        ++i;
+    }
+    size_t first = i;
+    long long magnitude = 0;
+    for (; i < text.length && text.data[i] >= '0' && text.data[i] <= '9'; ++i) {
+        magnitude = magnitude * 10 + (text.data[i] - '0');
+        if (magnitude > (long long)INT_MAX + 1) {
+            return false;
+        }
+    }
+    if (i == first || (!negative && magnitude > INT_MAX)) {
+        return false;
+    }
+    value = (int)(negative ? -magnitude : magnitude);
+    return true;
+}
+
+// Hashes the whole key (64-bit MurmurHash2 variant), so keys sharing a prefix spread evenly.
+inline uint64_t hashString(const char* key, size_t length) {
+    const uint64_t m = 0xc6a4a7935bd1e995ULL;
+    const int r = 47;
+    uint64_t h = 0x9747b28c ^ (length * m);
+
+    size_t blocks = length / 8;
+    for (size_t i = 0; i < blocks; ++i) {
+        uint64_t k = 0;
+        for (int b = 7; b >= 0; --b) {
+            k = (k << 8) | (unsigned char)key[i * 8 + b];
+        }
+        k *= m;
+        k ^= k >> r;
+        k *= m;
+        h ^= k;
+        h *= m;
+    }
+
+    const char* tail = key + blocks * 8;
+    switch (length & 7) {
+        case 7: h ^= uint64_t((unsigned char)tail[6]) << 48;
+                // fall through
+        case 6: h ^= uint64_t((unsigned char)tail[5]) << 40;
+                // fall through
+        case 5: h ^= uint64_t((unsigned char)tail[4]) << 32;
+                // fall through
+        case 4: h ^= uint64_t((unsigned char)tail[3]) << 24;
+                // fall through
+        case 3: h ^= uint64_t((unsigned char)tail[2]) << 16;
+                // fall through
+        case 2: h ^= uint64_t((unsigned char)tail[1]) << 8;
+                // fall through
+        case 1: h ^= uint64_t((unsigned char)tail[0]);
+                h *= m;
+    }
+
+    h ^= h >> r;
+    h *= m;
+    h ^= h >> r;
+    return h;
+}
+
+// Open addressing hash table with linear probing. Entries are kept densely in insertion
+// order, so iterating over `entries` never touches empty slots; `slots` only stores
+// indices into `entries`. Pointers returned by search() are invalidated by insertions.
 template <typename T>
 class HashTable {
 public:
-    HashTableNode<T> arr[sizeX];
+    static const int EMPTY = -1;
+    static const int TOMBSTONE = -2;
+
+    DynamicArray<HashTableNode<T>> entries;
+    DynamicArray<int> slots;
+    int tombstones;
+
+    HashTable() : slots(hashInitialCapacity, EMPTY), tombstones(0) {}
+
+    // Hashes the string key into a 64-bit value.
+    uint64_t hash(StringView key) {
+        return hashString(key.data, key.length);
+    }
+
+    // Number of keys stored.
+    int size() {
+        return entries.size();
+    }
+
+    // Makes room for n keys without rehashing.
+    void reserve(int n) {
+        int capacity = slots.size();
+        while ((long long)n * 100 > (long long)capacity * hashMaxLoadPercent) {
+            capacity *= 2;
+        }
+        if (capacity != slots.size()) {
+            rehash(capacity);
+        }
+    }
+
+    // Rebuilds the slot array with the given power of two capacity, dropping tombstones.
+    void rehash(int capacity) {
+        slots = DynamicArray<int>(capacity, EMPTY);
+        tombstones = 0;
+        int mask = capacity - 1;
+        for (int i = 0; i < entries.size(); ++i) {
+            int h = (int)(entries[i].hash & mask);
+            while (slots[h] != EMPTY) {
+                h = (h + 1) & mask;
+            }
+            slots[h] = i;
+        }
+    }
 
-    HashTable() {
-        for (int i = 0; i < sizeX; ++i) {
-            arr[i] = HashTableNode<T>();
+    // Returns the slot holding key, or -1 if it is absent.
+    int findSlot(StringView key, uint64_t h) {
+        int mask = slots.size() - 1;
+        int i = (int)(h & mask);
+        while (slots[i] != EMPTY) {
+            int e = slots[i];
+            if (e != TOMBSTONE && entries[e].hash == h && key == entries[e].key) {
+                return i;
+            }
+            i = (i + 1) & mask;
         }
+        return -1;
     }
-    // Hashes the string key into an integer index.
-    int hash(string key) {
-        return (key[0] - 'A' + sizeX) % sizeX;
+
+    // Appends a new entry for a key that is known to be absent and returns its index.
+    int insertNew(const string& key, T val, uint64_t h) {
+        if ((long long)(entries.size() + tombstones + 1) * 100 > (long long)slots.size() * hashMaxLoadPercent) {
+            // Grow only when live keys need it; otherwise just sweep out the tombstones.
+            bool crowded = (long long)(entries.size() + 1) * 100 * 2 > (long long)slots.size() * hashMaxLoadPercent;
+            rehash(crowded ? slots.size() * 2 : slots.size());
+        }
+        int mask = slots.size() - 1;
+        int i = (int)(h & mask);
+        while (slots[i] >= 0) {
+            i = (i + 1) & mask;
+        }
+        if (slots[i] == TOMBSTONE) {
+            --tombstones;
+        }
+        slots[i] = entries.size();
+        entries.pushBack(HashTableNode<T>(key, val, h));
+        return slots[i];
     }
+
     // Subscript operator overloading.
     T& operator[](const string& key) {
-        int h = hash(key);
-        for (int i = 0; i < sizeX; ++i) {
-            if (arr[h].occupied && arr[h].key == key) {
-                return arr[h].data;  // Return a reference to the data
-            }
-            h = (h + 1) % sizeX;
+        uint64_t h = hash(key);
+        int slot = findSlot(key, h);
+        if (slot >= 0) {
+            return entries[slots[slot]].data;  // Return a reference to the data
         }
         // If key is not found, insert it with a default value.
-        insert(key, T());
-        return arr[hash(key)].data;
+        return entries[insertNew(key, T(), h)].data;
     }
 
     // Insert a key-value pair into the hash table.
     void insert(string key, T val) {
-        int h = hash(key);
-        for (int i = 0; i < sizeX; ++i) {
-            if (arr[h].occupied && arr[h].key == key) {
-                arr[h].data = val; // Update the value if key exists
-                return;
-            }
-            if (!arr[h].occupied) {
-                arr[h].key = key;
-                arr[h].data = val;
-                arr[h].occupied = true;
-                return;
-            }
-            h = (h + 1) % sizeX;
+        uint64_t h = hash(key);
+        int slot = findSlot(key, h);
+        if (slot >= 0) {
+            entries[slots[slot]].data = val; // Update the value if key exists
+            return;
         }
+        insertNew(key, val, h);
     }
 
     // Returns a reference to the object.
-    T* search(string key) {
-        int h = hash(key);
-        for (int i = 0; i < sizeX; ++i) {
-            if (arr[h].occupied && arr[h].key == key) {
-                return &arr[h].data;
-            }
-            h = (h + 1) % sizeX;
+    T* search(StringView key) {
+        int slot = findSlot(key, hash(key));
+        if (slot < 0) {
+            return nullptr;
         }
-        return nullptr;
+        return &entries[slots[slot]].data;
     }
 
     // Checks if it contains a key.
-    bool contains(string key) {
+    bool contains(StringView key) {
         return search(key) != nullptr;
     }
 
+    // Removes a key, leaving a tombstone in its slot. The last entry moves into the hole.
+    bool remove(StringView key) {
+        int slot = findSlot(key, hash(key));
+        if (slot < 0) {
+            return false;
+        }
+        int removed = slots[slot];
+        slots[slot] = TOMBSTONE;
+        ++tombstones;
+
+        int last = entries.size() - 1;
+        if (removed != last) {
+            int lastSlot = findSlot(entries[last].key, entries[last].hash);
+            entries[removed] = entries[last];
+            slots[lastSlot] = removed;
+        }
+        entries.popBack();
+        return true;
+    }
+
+    // Removes every key but keeps the allocated slots.
+    void clear() {
+        entries.clear();
+        slots.fill(EMPTY);
+        tombstones = 0;
+    }
+
     // Prints the list.
     void printList() {
-        for (int i = 0; i < sizeX; ++i) {
-            if (arr[i].occupied) {
-                cout << "(" << arr[i].data.destination << ", "
-                     << arr[i].data.weight << ", "
-                     << arr[i].data.vehicles << ")";
-                if (i != sizeX-1)
-                    cout << " -> ";
-            }
+        for (int i = 0; i < entries.size(); ++i) {
+            cout << "(" << entries[i].data.destination << ", "
+                 << entries[i].data.weight << ", "
+                 << entries[i].data.vehicles << ")";
+            if (i != entries.size() - 1)
+                cout << " -> ";
         }
     }
 };
 
+// Keys under which MinHeap remembers the entries it already holds.
+inline string heapKey(const string& id) {
+    return id;
+}
+
+inline string heapKey(const Vehicles& id) {
+    return id.id;
+}
+
+// Position index for heap entries with arbitrary ids, looked up through heapKey.
 template <typename T>
+class HashedPositions {
+public:
+    HashTable<int> slots;
+
+    int find(const T& id) {
+        int* slot = slots.search(heapKey(id));
+        return slot ? *slot : -1;
+    }
+
+    void set(const T& id, int slot) {
+        slots.insert(heapKey(id), slot);
+    }
+
+    void erase(const T& id) {
+        slots.remove(heapKey(id));
+    }
+};
+
+// Position index for heap entries whose ids are dense node indices.
+class DensePositions {
+public:
+    DynamicArray<int> slots;
+
+    int find(uint32_t id) {
+        return id < (uint32_t)slots.size() ? slots[id] : -1;
+    }
+
+    void set(uint32_t id, int slot) {
+        if (id >= (uint32_t)slots.size()) {
+            slots.resize(id + 1, -1);
+        }
+        slots[id] = slot;
+    }
+
+    void erase(uint32_t id) {
+        slots[id] = -1;
+    }
+};
+
+// Set of dense node indices, one bit per node.
+class DenseBitset {
+public:
+    DynamicArray<uint64_t> words;
+
+    // Makes room for bits indices and clears every bit.
+    void reset(int bits) {
+        words.resize((bits + 63) / 64);
+        words.fill(0);
+    }
+
+    bool test(uint32_t i) const {
+        return (words.items[i >> 6] >> (i & 63)) & 1;
+    }
+
+    void set(uint32_t i) {
+        words[i >> 6] |= uint64_t(1) << (i & 63);
+    }
+};
+
+// Array backed d-ary min heap. The position index records where every id sits in
+// the array, so contains() is O(1) and decreaseKey() only sifts one entry up.
+template <typename T, int Arity = 4, typename Positions = HashedPositions<T>>
 class MinHeap {
 public:
-    LinkedList<MinHeapNode<T>> heap;  // Underlying structure for the heap
-    HashTable<Node<MinHeapNode<T>>> hashMap;  // HashMap to store objects of MinHeapNode
+    DynamicArray<MinHeapNode<T>> heap;  // Underlying structure for the heap
+    Positions positions;                // Slot of every id currently in the heap
 
-    // Inserts a new node into the heap
+    // Inserts a new node into the heap, or lowers the priority of an existing one.
     void insert(T id, int priority) {
-        Node<MinHeapNode<T>>* existingNode = hashMap.search(id);
-        if (existingNode) {
-            if (existingNode->data.priority > priority) {
-                existingNode->data.priority = priority;  // Update priority if it's better
+        int slot = positions.find(id);
+        if (slot >= 0) {
+            if (heap[slot].priority > priority) {
+                heap[slot].priority = priority;  // Update priority if it's better
+                siftUp(slot);
             }
             return;
         }
 
-        MinHeapNode<T> newNode(id, priority);
-        heap.enqueue(newNode);
-        hashMap.insert(id, *heap.tail);  // Store the object in the HashMap
+        heap.pushBack(MinHeapNode<T>(id, priority));
+        positions.set(id, heap.size() - 1);
+        siftUp(heap.size() - 1);
     }
 
-    // Helper function to swap data between two nodes
-    void swap(Node<MinHeapNode<T>>* a, Node<MinHeapNode<T>>* b) {
-        MinHeapNode<T> temp = a->data;
-        a->data = b->data;
-        b->data = temp;
+    // Lowers the priority of an id that is already in the heap.
+    void decreaseKey(T id, int priority) {
+        int slot = positions.find(id);
+        if (slot >= 0 && priority < heap[slot].priority) {
+            heap[slot].priority = priority;
+            siftUp(slot);
+        }
+    }
 
-        hashMap.insert(a->data.id, *a);
-        hashMap.insert(b->data.id, *b);
+    // Checks if an id is waiting in the heap.
+    bool contains(T id) {
+        return positions.find(id) >= 0;
     }
 
-    // Finds the node with the minimum priority
-    Node<MinHeapNode<T>>* findMinNode() {
-        Node<MinHeapNode<T>>* minNode = heap.head;
-        Node<MinHeapNode<T>>* current = heap.head;
+    // Returns the priority of an id in the heap, or INT_MAX if it isn't there.
+    int priorityOf(T id) {
+        int slot = positions.find(id);
+        return slot >= 0 ? heap[slot].priority : INT_MAX;
+    }
 
-        while (current) {
-            if (current->data.priority < minNode->data.priority) {
-                minNode = current;
-            }
-            current = current->next;
-        }
-        return minNode;
+    // Returns the node with the minimum priority without removing it.
+    MinHeapNode<T>& peekMin() {
+        return heap[0];
     }
 
     // Extracts the node with the minimum priority
-    MinHeapNode<T> getMin() {
+    MinHeapNode<T> extractMin() {
         if (heap.isEmpty()) {
             return MinHeapNode<T>();
         }
 
-        Node<MinHeapNode<T>>* minNode = findMinNode();
-        MinHeapNode<T> minValue = minNode->data;
+        MinHeapNode<T> minValue = heap[0];
+        positions.erase(minValue.id);
 
-        // Remove from the hashMap
-        hashMap.insert(minNode->data.id, Node<MinHeapNode<T>>());  // Replace with an empty node
+        MinHeapNode<T> last = heap.popBack();
+        if (!heap.isEmpty()) {
+            heap[0] = last;
+            positions.set(last.id, 0);
+            siftDown(0);
+        }
+        return minValue;
+    }
 
-        // Remove from the list
-        if (minNode == heap.head) {
-            heap.dequeue();
-        } else {
-            Node<MinHeapNode<T>>* current = heap.head;
-            while (current->next != minNode) {
-                current = current->next;
+    // Moves the entry at slot towards the root until its parent is not larger.
+    void siftUp(int slot) {
+        MinHeapNode<T> moving = heap[slot];
+        while (slot > 0) {
+            int parent = (slot - 1) / Arity;
+            if (!(moving < heap[parent])) {
+                break;
+            }
+            heap[slot] = heap[parent];
+            positions.set(heap[slot].id, slot);
+            slot = parent;
+        }
+        heap[slot] = moving;
+        positions.set(moving.id, slot);
+    }
+
+    // Moves the entry at slot towards the leaves until no child is smaller.
+    void siftDown(int slot) {
+        MinHeapNode<T> moving = heap[slot];
+        int count = heap.size();
+        while (true) {
+            int first = slot * Arity + 1;
+            if (first >= count) {
+                break;
+            }
+            int smallest = first;
+            int last = first + Arity < count ? first + Arity : count;
+            for (int child = first + 1; child < last; ++child) {
+                if (heap[child] < heap[smallest]) {
+                    smallest = child;
+                }
             }
-            current->next = minNode->next;
-            if (minNode == heap.tail) {
-                heap.tail = current;
+            if (!(heap[smallest] < moving)) {
+                break;
             }
-            delete minNode;
+            heap[slot] = heap[smallest];
+            positions.set(heap[slot].id, slot);
+            slot = smallest;
         }
+        heap[slot] = moving;
+        positions.set(moving.id, slot);
+    }
 
-        return minValue;
+    // Removes every entry, touching only the ones still queued.
+    void clear() {
+        for (int i = 0; i < heap.size(); ++i) {
+            positions.erase(heap[i].id);
+        }
+        heap.clear();
     }
 
     // Checks if the heap is empty
@@ -395,595 +818,4316 @@ public:
         return heap.isEmpty();
     }
 
+    int size() {
+        return heap.size();
+    }
+
     // Prints the heap (for debugging)
     void printHeap() {
-        Node<MinHeapNode<T>>* current = heap.head;
-        while (current) {
-            cout << "(" << current->data.id << ", " << current->data.priority << ")";
-            if (current->next) {
+        for (int i = 0; i < heap.size(); ++i) {
+            cout << "(" << heap[i].id << ", " << heap[i].priority << ")";
+            if (i != heap.size() - 1) {
                 cout << " -> ";
             }
-            current = current->next;
         }
         cout << endl;
     }
 };
 
-class GraphNode {
-public:
-    string id;
-    int greenTime;
-    LinkedList<Edge> neighbors;
+// Heap of node indices used by the shortest path searches.
+template <int Arity = 4>
+using NodeHeap = MinHeap<uint32_t, Arity, DensePositions>;
 
-    GraphNode(string id = "", int greenTime = 0) : id(id), greenTime(greenTime) {}
-    // Appends a neighbor to the intersection.
-    void addNeighbor(string& neighborId, int weight, int vehicles = 0) {
-        if (!neighbors.contains(neighborId)) {
-            neighbors.enqueue(Edge(neighborId, weight, vehicles));
-        }
-    }
-    // Returns the edge that points to a neighbor
-    Edge* getEdge(string& neighborId) {
-        return neighbors.get(neighborId);
-    }
+const int bucketQueueMaxWeight = 1 << 16; // Largest edge weight for which searches use a BucketQueue.
+
+// Selects the priority queue behind a shortest path search.
+enum QueueBackend {
+    AUTO_QUEUE,   // Bucket queue when all weights are small non-negative integers, heap otherwise.
+    HEAP_QUEUE,   // Always the d-ary NodeHeap.
+    BUCKET_QUEUE  // The bucket queue; falls back to the heap if a weight lies outside 0 .. bucketQueueMaxWeight.
 };
 
-class Graph {
+// Dial's bucket queue for node indices with monotone integer keys. While Dijkstra runs,
+// every queued key lies between the last extracted key and that key plus the largest
+// edge weight, so maxWeight + 1 buckets used circularly hold them all. Each bucket is an
+// intrusive doubly linked list threaded through per-node arrays, which makes insert and
+// decreaseKey O(1) and extractMin amortised O(1).
+class BucketQueue {
 public:
-    int timer = 0;
-    HashTable<GraphNode> vertices;
-    LinkedList<Vehicles> vehicles;
-    MinHeap<Vehicles> emergencyVehicles;
+    DynamicArray<uint32_t> buckets;  // First node of every bucket
+    DynamicArray<uint32_t> next;
+    DynamicArray<uint32_t> prev;
+    DynamicArray<int> keys;          // Key of every queued node, -1 if it isn't queued
+    int cursor;                      // Lower bound on every queued key
+    int count;
 
-    // Find a node by id (
-    GraphNode* findNode(string& id) {
-        GraphNode *node = vertices.search(id);
-        return node;
+    BucketQueue(int nodeCount = 0, int maxWeight = 0) : cursor(0), count(0) {
+        reset(nodeCount, maxWeight);
     }
 
-    // Add a node to the graph
-    void addNode(string& id) {
-        if (findNode(id)) {
-            return;  // Node already exists
+    // Empties the queue and sizes it for nodeCount nodes and keys spread by at most
+    // maxWeight. Only nodes still queued are touched, so reuse is cheap after a search.
+    void reset(int nodeCount, int maxWeight) {
+        while (count > 0) {
+            extractMin();
         }
-        GraphNode newNode(id);  // Create a new GraphNode
-        vertices.insert(id, newNode);  // Insert the GraphNode object into the HashTable
+        if (buckets.size() != maxWeight + 1) {
+            buckets = DynamicArray<uint32_t>(maxWeight + 1, NO_NODE);
+        }
+        if (keys.size() < nodeCount) {
+            next.resize(nodeCount, NO_NODE);
+            prev.resize(nodeCount, NO_NODE);
+            keys.resize(nodeCount, -1);
+        }
+        cursor = 0;
     }
 
-    // Get the edge between two nodes
-    Edge* getEdge(string& from, string& to) {
-        GraphNode* fromNode = findNode(from);
-        if (!fromNode) {
-            cout << "Invalid nodes.\n";
-            return nullptr;
+    // Links a node at the front of the bucket for its key.
+    void link(uint32_t id, int priority) {
+        int b = priority % buckets.size();
+        keys[id] = priority;
+        prev[id] = NO_NODE;
+        next[id] = buckets[b];
+        if (buckets[b] != NO_NODE) {
+            prev[buckets[b]] = id;
         }
-        return fromNode->getEdge(to);
+        buckets[b] = id;
     }
 
-    // Block an edge between two nodes
-    void blockEdge(string from, string to) {
-        GraphNode* fromNode = findNode(from);
-        if (!fromNode) {
-            cout << "Node '" << from << "' doesn't exist.\n";
-            return;
-        }
-        Edge* edge = fromNode->getEdge(to);
-        if (edge) {
-            edge->block();
-            cout << "Road blocked from " << from << " to " << to << endl;
+    // Removes a node from the bucket it is linked into.
+    void unlink(uint32_t id) {
+        if (prev[id] != NO_NODE) {
+            next[prev[id]] = next[id];
         } else {
-            cout << "Road doesn't exist.\n";
+            buckets[keys[id] % buckets.size()] = next[id];
         }
+        if (next[id] != NO_NODE) {
+            prev[next[id]] = prev[id];
+        }
+        keys[id] = -1;
     }
 
-    // Add an edge between two nodes
-    void addEdge(string& from, string& to, int weight, int vehicles = 0) {
-        GraphNode* fromNode = findNode(from);
-        GraphNode* toNode = findNode(to);
-
-        if (!fromNode || !toNode) {
-            cout << "Either one of the nodes is missing!\n";
+    // Inserts a new node, or lowers the key of one that is already queued.
+    void insert(uint32_t id, int priority) {
+        if (keys[id] >= 0) {
+            decreaseKey(id, priority);
             return;
         }
-
-        // Add edge between fromNode and toNode
-        if (!fromNode->neighbors.contains(to)) {
-            fromNode->addNeighbor(to, weight, vehicles);
+        if (count == 0 || priority < cursor) {
+            cursor = priority;
         }
+        link(id, priority);
+        ++count;
     }
 
-    // Function to find and print all possible routes from start node to end node
-    void findAllPaths(string from, string to) {
-        GraphNode* start = findNode(from);
-        GraphNode* end = findNode(to);
-        if (!start || !end) {
-            cout << "Start or end node not found!" << endl;
+    void decreaseKey(uint32_t id, int priority) {
+        if (keys[id] < 0 || priority >= keys[id]) {
             return;
         }
+        unlink(id);
+        link(id, priority);
+        if (priority < cursor) {
+            cursor = priority;
+        }
+    }
 
-        HashTable<bool> visited;
-        findAllPathsHelper(from, to, "", 0, visited);
+    bool contains(uint32_t id) {
+        return keys[id] >= 0;
     }
 
-    // Helper function for DFS to find and print all paths
-    void findAllPathsHelper(string from, string to, string path, int weight, HashTable<bool>& visited) {
-        visited.insert(from, true);
-        path += from + " ";
+    // Returns a node with the minimum key without removing it, advancing the cursor to it.
+    MinHeapNode<uint32_t> peekMin() {
+        int b = cursor % buckets.size();
+        while (buckets[b] == NO_NODE) {
+            ++cursor;
+            b = cursor % buckets.size();
+        }
+        return MinHeapNode<uint32_t>(buckets[b], cursor);
+    }
 
-        if (from == to) {
-            cout << "Path: " << path << " | Total Weight: " << weight << endl;
-        } else {
-            GraphNode* currentNode = findNode(from);
-            if (currentNode) {
-                Node<Edge>* neighbor = currentNode->neighbors.head;
-                while (neighbor) {
-                    if (!visited[neighbor->data.destination]) {
-                        int edgeWeight = neighbor->data.weight;
-                        findAllPathsHelper(neighbor->data.destination, to, path, weight + edgeWeight, visited);
-                    }
-                    neighbor = neighbor->next;
-                }
-            }
+    // Extracts a node with the minimum key, scanning forward from the cursor.
+    MinHeapNode<uint32_t> extractMin() {
+        if (count == 0) {
+            return MinHeapNode<uint32_t>(NO_NODE);
         }
+        uint32_t id = peekMin().id;
+        MinHeapNode<uint32_t> minValue(id, keys[id]);
+        unlink(id);
+        --count;
+        return minValue;
+    }
 
-        visited.insert(from, false);
+    bool isEmpty() {
+        return count == 0;
     }
 
-    // Print the entire graph
-    void printGraph() {
-        cout << "------ City Traffic Network ------" << endl;
-        for (int i = 0; i < sizeX; ++i) {
-            if (vertices.arr[i].occupied) {
-                cout << vertices.arr[i].data.id << " -> ";
-                vertices.arr[i].data.neighbors.printList();
-            }
-        }
+    int size() {
+        return count;
     }
+};
 
-    // Display all the vehicles and their destinations.
-    void showVehicles() {
-        Node<Vehicles>* head = vehicles.head;
-        while (head) {
-            cout << head->data.id << " moving from " << head->data.start << " to " << head->data.end << endl;
-            head = head->next;
-        }
+// Hierarchical timing wheel of ids due at integer times. Level l has 64 slots of 64^l
+// seconds each; an entry sits on the lowest level whose slot still tells its time apart
+// from now. Each second that passes empties one slot of level 0, and whenever a level's
+// slot index wraps around, the current slot of the next level is spread over the finer ones.
+// Advancing costs the entries that fall due plus one step per second, skipping stretches in
+// which level 0 is empty.
+class TimingWheel {
+public:
+    static const int slotBits = 6;
+    static const int slotCount = 1 << slotBits;
+    static const int levelCount = 4;
+    // Seconds the levels cover. Entries further out wait in later and are filed again each
+    // time the wheel completes a full span.
+    static const int span = 1 << (slotBits * levelCount);
+
+    class Entry {
+    public:
+        uint32_t id;
+        int time;
+
+        Entry(uint32_t id = 0, int time = 0) : id(id), time(time) {}
+    };
+
+    DynamicArray<DynamicArray<Entry>> slots;  // Slot s of level l at l * slotCount + s
+    DynamicArray<int> levelSizes;
+    DynamicArray<Entry> later;
+    int now = 0;
+    int size = 0;
+
+    TimingWheel() {
+        slots.resize(levelCount * slotCount);
+        levelSizes.resize(levelCount, 0);
     }
 
-    // Display all the emergency vehicles and their destinations.
-    void showEmergencyVehicles() {
-        Node<MinHeapNode<Vehicles>> *head = emergencyVehicles.heap.head;
-        while (head) {
-            cout << head->data.id.id << " moving from " << head->data.id.start << " to " << head->data.id.end << " with priority " << head->data.priority << endl;
-            head = head->next;
+    // Empties the wheel and sets its clock.
+    void reset(int time) {
+        for (int i = 0; i < slots.size(); ++i) {
+            slots[i].clear();
         }
+        levelSizes.fill(0);
+        later.clear();
+        now = time;
+        size = 0;
     }
 
-    // Show blocked roads
-    void showBlocked() {
-        cout << "------ Blocked Roads ------" << endl;
-        for (int i = 0; i < sizeX; ++i) {
-            if (vertices.arr[i].occupied) {
-                GraphNode& node = vertices.arr[i].data;
-                Node<Edge>* current = node.neighbors.head;
-                while (current) {
-                    if (current->data.blocked) {
-                        cout << node.id << " to " << current->data.destination << " is blocked.\n";
-                    }
-                    current = current->next;
-                }
-            }
-        }
+    // Schedules id at time, which must lie after now.
+    void schedule(uint32_t id, int time) {
+        ++size;
+        place(Entry(id, time));
+    }
+
+    // Files an entry on the level and slot its time falls in, seen from now.
+    void place(const Entry& entry) {
+        if (entry.time - now >= span) {
+            later.pushBack(entry);
+            return;
+        }
+        int level = 0;
+        while (level + 1 < levelCount && (entry.time >> (slotBits * (level + 1))) != (now >> (slotBits * (level + 1)))) {
+            ++level;
+        }
+        slots[level * slotCount + ((entry.time >> (slotBits * level)) & (slotCount - 1))].pushBack(entry);
+        ++levelSizes[level];
+    }
+
+    // Moves the clock to time and appends the ids due up to and including it to due.
+    void advance(int time, DynamicArray<uint32_t>& due) {
+        while (now < time) {
+            if (size == 0) {
+                now = time;
+                break;
+            }
+            if (levelSizes[0] == 0 && (now & (slotCount - 1)) != slotCount - 1) {
+                // Nothing can fall due before the next cascade, so skip to just before it.
+                int boundary = now | (slotCount - 1);
+                now = boundary < time ? boundary : time;
+                continue;
+            }
+            ++now;
+            for (int level = levelCount - 1; level > 0; --level) {
+                if ((now & ((1 << (slotBits * level)) - 1)) == 0) {
+                    cascade(level);
+                }
+            }
+            if ((now & (span - 1)) == 0) {
+                DynamicArray<Entry> waiting;
+                waiting.swapWith(later);
+                for (int i = 0; i < waiting.size(); ++i) {
+                    place(waiting[i]);
+                }
+            }
+            DynamicArray<Entry>& slot = slots[now & (slotCount - 1)];
+            for (int i = 0; i < slot.size(); ++i) {
+                due.pushBack(slot[i].id);
+            }
+            levelSizes[0] -= slot.size();
+            size -= slot.size();
+            slot.clear();
+        }
+    }
+
+    // Spreads the current slot of a level over the levels below it.
+    void cascade(int level) {
+        DynamicArray<Entry> moving;
+        moving.swapWith(slots[level * slotCount + ((now >> (slotBits * level)) & (slotCount - 1))]);
+        levelSizes[level] -= moving.size();
+        for (int i = 0; i < moving.size(); ++i) {
+            place(moving[i]);
+        }
+    }
+};
+
+// How a route treats roads that are currently blocked.
+enum BlockedPolicy {
+    AVOID_BLOCKED,  // Regular traffic waits for closures and red lights.
+    IGNORE_BLOCKED  // Emergency vehicles drive through them.
+};
+
+// Search strategy the routing engine uses for a query. All of them return the same cost.
+enum RouteAlgorithm {
+    DIJKSTRA,                // Forward search from the source
+    BIDIRECTIONAL_DIJKSTRA,  // Forward and backward searches that meet in the middle
+    ALT,                     // A* guided by landmark lower bounds
+    CONTRACTION_HIERARCHY,   // Upward searches on a precomputed node hierarchy; AVOID_BLOCKED queries use the overlay
+    CUSTOMIZABLE_OVERLAY     // Multi-level cell overlay; IGNORE_BLOCKED queries use the hierarchy
+};
+
+// Name of a search strategy as printed next to its routes.
+const char* algorithmName(RouteAlgorithm algorithm) {
+    switch (algorithm) {
+        case BIDIRECTIONAL_DIJKSTRA: return "Bidirectional Dijkstra";
+        case ALT: return "ALT";
+        case CONTRACTION_HIERARCHY: return "Contraction hierarchy";
+        case CUSTOMIZABLE_OVERLAY: return "Customizable overlay";
+        default: return "Dijkstra";
+    }
+}
+
+// A point to point request for the routing engine.
+class RouteQuery {
+public:
+    uint32_t source;
+    uint32_t target;
+    BlockedPolicy blockedPolicy;
+    int maxCost;  // The search gives up on routes costing more than this.
+    RouteAlgorithm algorithm;
+    QueueBackend queue;  // Queue of the Dijkstra based searches
+
+    RouteQuery(uint32_t source = NO_NODE, uint32_t target = NO_NODE,
+               BlockedPolicy blockedPolicy = AVOID_BLOCKED, int maxCost = INT_MAX,
+               RouteAlgorithm algorithm = DIJKSTRA, QueueBackend queue = AUTO_QUEUE)
+        : source(source), target(target), blockedPolicy(blockedPolicy), maxCost(maxCost), algorithm(algorithm),
+          queue(queue) {}
+};
+
+// Work counters of a single search.
+class RouteStats {
+public:
+    int settled;  // Nodes taken off the queue
+    int relaxed;  // Roads examined from settled nodes
+
+    RouteStats() : settled(0), relaxed(0) {}
+};
+
+// Answer of the routing engine. path lists node indices from source to target and is
+// empty when no route within maxCost exists.
+class RouteResult {
+public:
+    bool found;
+    int cost;
+    DynamicArray<uint32_t> path;
+    RouteStats stats;
+
+    RouteResult() : found(false), cost(INT_MAX) {}
+};
+
+// A request for the distances between every source and every target.
+class MatrixQuery {
+public:
+    DynamicArray<uint32_t> sources;
+    DynamicArray<uint32_t> targets;
+    BlockedPolicy blockedPolicy;
+    bool withPaths;      // Also return the node index path of every pair.
+    QueueBackend queue;  // Queue of the searches
+
+    MatrixQuery(BlockedPolicy blockedPolicy = AVOID_BLOCKED, bool withPaths = false, QueueBackend queue = AUTO_QUEUE)
+        : blockedPolicy(blockedPolicy), withPaths(withPaths), queue(queue) {}
+};
+
+// Answer of a matrix query: one row per source and one column per target, INT_MAX where a
+// target can't be reached. paths is only filled when the query asked for it.
+class DistanceMatrix {
+public:
+    int rows;
+    int columns;
+    DynamicArray<int> costs;
+    DynamicArray<DynamicArray<uint32_t>> paths;
+    RouteStats stats;  // Work of all searches together
+
+    DistanceMatrix(int rows = 0, int columns = 0, bool withPaths = false)
+        : rows(rows), columns(columns), costs(rows * columns, INT_MAX) {
+        if (withPaths) paths.resize(rows * columns);
+    }
+
+    int& cost(int row, int column) {
+        return costs[row * columns + column];
+    }
+
+    DynamicArray<uint32_t>& path(int row, int column) {
+        return paths[row * columns + column];
+    }
+};
+
+// Scratch state reused by every search on one thread. A distance or parent entry only
+// counts when its stamp equals the current epoch, so starting a new search is a single
+// counter bump and a search pays only for the nodes it touches, not for the whole city.
+class QueryWorkspace {
+public:
+    DynamicArray<int> distances;
+    DynamicArray<uint32_t> parents;
+    DynamicArray<uint32_t> stamps;
+    uint32_t epoch;
+    NodeHeap<> heap;
+    BucketQueue buckets;
+    DynamicArray<uint8_t> marks;  // Targets of a multi-target search, all clear between searches
+
+    QueryWorkspace() : epoch(0) {}
+
+    // Starts a new search over a graph with nodeCount nodes.
+    void reset(int nodeCount) {
+        if (stamps.size() < nodeCount) {
+            distances.resize(nodeCount, INT_MAX);
+            parents.resize(nodeCount, NO_NODE);
+            stamps.resize(nodeCount, 0);
+            marks.resize(nodeCount, 0);
+            heap.positions.slots.resize(nodeCount, -1);
+        }
+        heap.clear();
+        if (++epoch == 0) {
+            // The counter wrapped around, so old stamps could look current again.
+            stamps.fill(0);
+            epoch = 1;
+        }
+    }
+
+    // Prepares the bucket queue for weights up to maxWeight.
+    BucketQueue& bucketQueue(int nodeCount, int maxWeight) {
+        buckets.reset(nodeCount, maxWeight);
+        return buckets;
+    }
+
+    int distance(uint32_t node) {
+        return stamps[node] == epoch ? distances[node] : INT_MAX;
+    }
+
+    uint32_t parent(uint32_t node) {
+        return stamps[node] == epoch ? parents[node] : NO_NODE;
+    }
+
+    void set(uint32_t node, int distance, uint32_t parent) {
+        stamps[node] = epoch;
+        distances[node] = distance;
+        parents[node] = parent;
+    }
+};
+
+// Returns one of the calling thread's workspaces. Bidirectional searches use
+// workspace 0 for the forward side and workspace 1 for the backward side.
+inline QueryWorkspace& localWorkspace(int which = 0) {
+    thread_local QueryWorkspace workspaces[2];
+    return workspaces[which];
+}
+
+class GraphNode {
+public:
+    string id;
+    int greenTime;
+    int phaseOffset = 0;            // Shifts the signal cycle, for green waves.
+    LinkedList<Edge> neighbors;
+    LinkedList<uint32_t> incoming;  // Intersections with a road leading here.
+
+    GraphNode(string id = "", int greenTime = 0) : id(id), greenTime(greenTime) {}
+
+    // True if the signal shows red at time. It is green for greenTime seconds, then red for
+    // as long, starting green at -phaseOffset. Intersections without a signal never stop traffic.
+    bool isRed(int time) {
+        return greenTime > 0 && ((time + phaseOffset) / greenTime) % 2 == 1;
+    }
+    // Appends a neighbor to the intersection. Returns false if the road already exists.
+    bool addNeighbor(uint32_t neighbor, int weight, int vehicles = 0) {
+        if (!neighbors.contains(neighbor)) {
+            neighbors.enqueue(Edge(neighbor, weight, vehicles));
+            return true;
+        }
+        return false;
+    }
+    // Returns the edge that points to a neighbor
+    Edge* getEdge(uint32_t neighbor) {
+        return neighbors.get(neighbor);
+    }
+};
+
+const uint8_t EDGE_BLOCKED = 1; // Flag bit of a CSR slot whose road is closed.
+
+// Read-only compressed sparse row copy of the adjacency lists. The roads leaving
+// intersection u occupy slots offsets[u] .. offsets[u + 1] - 1 of the parallel
+// targets/weights/flags arrays, so a scan over them is a sequential walk in memory.
+// The reverse arrays hold the same roads grouped by the intersection they enter.
+// Closures are flags of the roads; signals are evaluated from the cycle of the intersection
+// a road leaves, at signalTime, whenever a search looks at the road.
+class CSRGraph {
+public:
+    DynamicArray<uint32_t> offsets;
+    DynamicArray<uint32_t> targets;
+    DynamicArray<int> weights;
+    DynamicArray<uint8_t> flags;
+    DynamicArray<uint32_t> reverseOffsets;
+    DynamicArray<uint32_t> sources;
+    DynamicArray<int> reverseWeights;
+    DynamicArray<uint8_t> reverseFlags;
+    DynamicArray<uint32_t> reverseSlots;  // Reverse slot of every forward slot
+    DynamicArray<int> greenTimes;         // Signal cycle of every node, 0 if it has no signal
+    DynamicArray<int> phaseOffsets;
+    int signalTime = 0;                   // Time at which searches see the signals
+    int minWeight = 0;
+    int maxWeight = 0;
+
+    // Rebuilds the arrays from the linked list adjacency of every node.
+    void build(DynamicArray<GraphNode>& nodes) {
+        int edgeCount = 0;
+        for (int i = 0; i < nodes.size(); ++i) {
+            for (Node<Edge>* current = nodes[i].neighbors.head; current; current = current->next) {
+                ++edgeCount;
+            }
+        }
+
+        offsets.resize(nodes.size() + 1);
+        greenTimes.resize(nodes.size());
+        phaseOffsets.resize(nodes.size());
+        targets.resize(edgeCount);
+        weights.resize(edgeCount);
+        flags.resize(edgeCount);
+
+        uint32_t slot = 0;
+        minWeight = maxWeight = 0;
+        for (int i = 0; i < nodes.size(); ++i) {
+            offsets[i] = slot;
+            greenTimes[i] = nodes[i].greenTime;
+            phaseOffsets[i] = nodes[i].phaseOffset;
+            for (Node<Edge>* current = nodes[i].neighbors.head; current; current = current->next) {
+                targets[slot] = current->data.destination;
+                weights[slot] = current->data.weight;
+                if (slot == 0 || current->data.weight < minWeight) minWeight = current->data.weight;
+                if (slot == 0 || current->data.weight > maxWeight) maxWeight = current->data.weight;
+                flags[slot] = current->data.blocked ? EDGE_BLOCKED : 0;
+                ++slot;
+            }
+        }
+        offsets[nodes.size()] = slot;
+
+        // Reverse rows come from each node's incoming list, in the order the roads were added.
+        reverseOffsets.resize(nodes.size() + 1);
+        sources.resize(edgeCount);
+        reverseWeights.resize(edgeCount);
+        reverseFlags.resize(edgeCount);
+        reverseSlots.resize(edgeCount);
+        uint32_t reverseSlot = 0;
+        for (int i = 0; i < nodes.size(); ++i) {
+            reverseOffsets[i] = reverseSlot;
+            for (Node<uint32_t>* current = nodes[i].incoming.head; current; current = current->next) {
+                int forwardSlot = findSlot(current->data, i);
+                sources[reverseSlot] = current->data;
+                reverseWeights[reverseSlot] = weights[forwardSlot];
+                reverseFlags[reverseSlot] = flags[forwardSlot];
+                reverseSlots[forwardSlot] = reverseSlot;
+                ++reverseSlot;
+            }
+        }
+        reverseOffsets[nodes.size()] = reverseSlot;
+    }
+
+    int nodeCount() {
+        return offsets.size() - 1;
+    }
+
+    int edgeCount() {
+        return targets.size();
+    }
+
+    // Returns the slot of the road from -> to, or -1 if there is none.
+    int findSlot(uint32_t from, uint32_t to) {
+        for (uint32_t e = offsets[from]; e < offsets[from + 1]; ++e) {
+            if (targets[e] == to) {
+                return e;
+            }
+        }
+        return -1;
+    }
+
+    bool isClosed(uint32_t slot) {
+        return flags[slot] & EDGE_BLOCKED;
+    }
+
+    // True if the signal of node shows red at time, as GraphNode::isRed.
+    bool isRed(uint32_t node, int time) {
+        return greenTimes[node] > 0 && ((time + phaseOffsets[node]) / greenTimes[node]) % 2 == 1;
+    }
+
+    bool isRed(uint32_t node) {
+        return isRed(node, signalTime);
+    }
+
+    // First time after time at which the signal of node changes. Only for nodes with a signal.
+    int nextSignalChange(uint32_t node, int time) {
+        return ((time + phaseOffsets[node]) / greenTimes[node] + 1) * greenTimes[node] - phaseOffsets[node];
+    }
+
+    // True if the road in slot, which leaves from, is closed or stopped by a red signal.
+    bool isBlocked(uint32_t from, uint32_t slot) {
+        return (flags[slot] & EDGE_BLOCKED) || isRed(from);
+    }
+
+    // Sets the blocked bit of a forward slot and of the matching reverse slot.
+    void setBlocked(uint32_t slot, bool blocked) {
+        flags[slot] = blocked ? (flags[slot] | EDGE_BLOCKED) : (flags[slot] & ~EDGE_BLOCKED);
+        reverseFlags[reverseSlots[slot]] = flags[slot];
+    }
+
+    // Sets the weight of a forward slot and of the matching reverse slot.
+    void setWeight(uint32_t slot, int weight) {
+        weights[slot] = weight;
+        reverseWeights[reverseSlots[slot]] = weight;
+        if (weight < minWeight) minWeight = weight;
+        if (weight > maxWeight) maxWeight = weight;
+    }
+};
+
+// Landmark distance tables for ALT (A*, landmarks, triangle inequality). For a landmark L
+// the triangle inequality gives d(v, t) >= d(L, t) - d(L, v) and d(v, t) >= d(v, L) - d(t, L),
+// and the largest of these over all landmarks is the A* potential of v. Distances ignore
+// blocked roads, so blocking a road keeps every bound valid; adding roads does not.
+class LandmarkIndex {
+public:
+    int count = 0;                       // Landmarks per node
+    DynamicArray<uint32_t> landmarks;
+    DynamicArray<int> fromLandmark;      // d(L, v) at v * count + l, INT_MAX if unreachable
+    DynamicArray<int> toLandmark;        // d(v, L) at v * count + l, INT_MAX if unreachable
+
+    // Picks up to landmarkCount landmarks by farthest point selection and fills both tables.
+    void build(CSRGraph& graph, int landmarkCount) {
+        int n = graph.nodeCount();
+        count = landmarkCount < n ? landmarkCount : n;
+        landmarks.clear();
+        fromLandmark.resize(n * count);
+        toLandmark.resize(n * count);
+
+        DynamicArray<int> from, to;
+        if (count == 0) return;
+        // Start from the node farthest from node 0, then keep taking the node that is
+        // farthest from all landmarks chosen so far. Nodes no landmark connects to count
+        // as infinitely far, so every part of a disconnected city gets a landmark.
+        distancesFrom(graph.offsets, graph.targets, graph.weights, 0, from);
+        uint32_t next = farthest(from);
+        DynamicArray<long long> closest(n, LLONG_MAX);
+        for (int l = 0; l < count; ++l) {
+            landmarks.pushBack(next);
+            distancesFrom(graph.offsets, graph.targets, graph.weights, next, from);
+            distancesFrom(graph.reverseOffsets, graph.sources, graph.reverseWeights, next, to);
+            for (int v = 0; v < n; ++v) {
+                fromLandmark[v * count + l] = from[v];
+                toLandmark[v * count + l] = to[v];
+                long long around = (from[v] == INT_MAX || to[v] == INT_MAX) ? LLONG_MAX : (long long)from[v] + to[v];
+                if (around < closest[v]) closest[v] = around;
+            }
+            next = 0;
+            for (int v = 1; v < n; ++v) {
+                if (closest[v] > closest[next]) next = v;
+            }
+        }
+    }
+
+    // Returns the node with the largest finite distance.
+    static uint32_t farthest(DynamicArray<int>& distances) {
+        uint32_t best = 0;
+        for (int v = 1; v < distances.size(); ++v) {
+            if (distances[v] != INT_MAX && (distances[best] == INT_MAX || distances[v] > distances[best])) {
+                best = v;
+            }
+        }
+        return best;
+    }
+
+    // Dijkstra from source over one direction of the snapshot, ignoring blocked roads.
+    static void distancesFrom(DynamicArray<uint32_t>& offsets, DynamicArray<uint32_t>& targets,
+                              DynamicArray<int>& weights, uint32_t source, DynamicArray<int>& out) {
+        int n = offsets.size() - 1;
+        out.resize(n);
+        out.fill(INT_MAX);
+        NodeHeap<> pq;
+        pq.positions.slots.resize(n, -1);
+        out[source] = 0;
+        pq.insert(source, 0);
+        while (!pq.isEmpty()) {
+            MinHeapNode<uint32_t> current = pq.extractMin();
+            for (uint32_t e = offsets[current.id]; e < offsets[current.id + 1]; ++e) {
+                int newDist = current.priority + weights[e];
+                if (newDist < out[targets[e]]) {
+                    out[targets[e]] = newDist;
+                    pq.insert(targets[e], newDist);
+                }
+            }
+        }
+    }
+
+    // Returns a lower bound on d(v, target), or INT_MAX if target is provably unreachable from v.
+    int lowerBound(uint32_t v, uint32_t target) {
+        int bound = 0;
+        if (count == 0) return bound;
+        const int* fromV = &fromLandmark[v * count];
+        const int* toV = &toLandmark[v * count];
+        const int* fromT = &fromLandmark[target * count];
+        const int* toT = &toLandmark[target * count];
+        for (int l = 0; l < count; ++l) {
+            if (toT[l] != INT_MAX) {
+                if (toV[l] == INT_MAX) return INT_MAX;  // t reaches L but v doesn't, so v can't reach t.
+                if (toV[l] - toT[l] > bound) bound = toV[l] - toT[l];
+            }
+            if (fromT[l] != INT_MAX && fromV[l] != INT_MAX && fromT[l] - fromV[l] > bound) {
+                bound = fromT[l] - fromV[l];
+            }
+        }
+        return bound;
+    }
+};
+
+// Returns how many threads parallel preprocessing uses.
+inline int workerCount() {
+    unsigned threads = thread::hardware_concurrency();
+    return threads == 0 ? 1 : (int)threads;
+}
+
+// Calls body(i, worker) for every i in [0, count), spread over workerCount() threads.
+// worker identifies the calling thread so the body can use per-thread scratch space.
+template <typename Body>
+void parallelFor(int count, Body body) {
+    int workers = workerCount();
+    atomic<int> next(0);
+    auto run = [&](int worker) {
+        const int chunk = 64;
+        for (int begin = next.fetch_add(chunk); begin < count; begin = next.fetch_add(chunk)) {
+            int end = begin + chunk < count ? begin + chunk : count;
+            for (int i = begin; i < end; ++i) {
+                body(i, worker);
+            }
+        }
+    };
+    DynamicArray<thread> threads;
+    for (int worker = 1; worker < workers && worker * 64 < count; ++worker) {
+        threads.pushBack(thread(run, worker));
+    }
+    run(0);
+    for (int i = 0; i < threads.size(); ++i) {
+        threads[i].join();
+    }
+}
+
+// Worker threads with one task queue each. A worker runs tasks from the front of its own
+// queue and, when that is empty, steals from the back of the others, so tasks start roughly
+// in submission order and no thread idles while any queue holds work. The submitting thread
+// runs tasks too while it waits. Batches are submitted from one thread at a time.
+class ThreadPool {
+public:
+    class TaskQueue {
+    public:
+        mutex lock;
+        DynamicArray<function<void()>> tasks;
+        int head = 0;
+
+        void push(function<void()> task) {
+            lock_guard<mutex> guard(lock);
+            tasks.pushBack(std::move(task));
+        }
+
+        // Takes the oldest task (fromFront) or the newest one.
+        bool take(function<void()>& task, bool fromFront) {
+            lock_guard<mutex> guard(lock);
+            if (head == tasks.size()) {
+                return false;
+            }
+            task = fromFront ? std::move(tasks[head++]) : tasks.popBack();
+            if (head == tasks.size()) {
+                tasks.clear();
+                head = 0;
+            }
+            return true;
+        }
+    };
+
+    DynamicArray<thread> workers;
+    TaskQueue* queues;          // One per worker, the last one belongs to the submitting thread.
+    int queueCount;
+    int nextQueue = 0;
+    atomic<int> queued;         // Tasks waiting in any queue
+    atomic<int> pending;        // Tasks submitted but not finished
+    mutex idleLock;
+    condition_variable wake;    // Signalled when tasks are queued or the pool stops
+    condition_variable done;    // Signalled when pending drops to zero
+    bool stopping = false;
+
+    ThreadPool(int threadCount) : queueCount(threadCount + 1), queued(0), pending(0) {
+        queues = new TaskQueue[queueCount];
+        for (int i = 0; i < threadCount; ++i) {
+            workers.pushBack(thread(&ThreadPool::workerLoop, this, i));
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            lock_guard<mutex> guard(idleLock);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (int i = 0; i < workers.size(); ++i) {
+            workers[i].join();
+        }
+        delete[] queues;
+    }
+
+    // Queues a task, spreading tasks over the queues round robin.
+    void submit(function<void()> task) {
+        ++pending;
+        queues[nextQueue].push(std::move(task));
+        nextQueue = (nextQueue + 1) % queueCount;
+        {
+            lock_guard<mutex> guard(idleLock);
+            ++queued;
+        }
+        wake.notify_one();
+    }
+
+    // Finds work for queue self: its own oldest task, else the newest task of another queue.
+    bool findTask(int self, function<void()>& task) {
+        for (int i = 0; i < queueCount; ++i) {
+            if (queues[(self + i) % queueCount].take(task, i == 0)) {
+                --queued;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void run(function<void()>& task) {
+        task();
+        if (--pending == 0) {
+            lock_guard<mutex> guard(idleLock);
+            done.notify_all();
+        }
+    }
+
+    void workerLoop(int self) {
+        function<void()> task;
+        for (;;) {
+            if (findTask(self, task)) {
+                run(task);
+                continue;
+            }
+            unique_lock<mutex> guard(idleLock);
+            wake.wait(guard, [this] { return stopping || queued > 0; });
+            if (stopping) return;
+        }
+    }
+
+    // Runs queued tasks on the calling thread as well and returns once all of them finished.
+    void wait() {
+        function<void()> task;
+        for (;;) {
+            if (findTask(queueCount - 1, task)) {
+                run(task);
+                continue;
+            }
+            unique_lock<mutex> guard(idleLock);
+            done.wait(guard, [this] { return pending == 0 || queued > 0; });
+            if (pending == 0) return;
+        }
+    }
+};
+
+// Returns the pool that batch routing runs on: one worker per hardware thread besides the caller.
+inline ThreadPool& routingPool() {
+    static ThreadPool pool(workerCount() - 1);
+    return pool;
+}
+
+// Distances and parents from one source to every intersection.
+class ShortestPathTree {
+public:
+    uint32_t source;
+    DynamicArray<int> distances;     // INT_MAX where unreachable
+    DynamicArray<uint32_t> parents;  // NO_NODE at the source and where unreachable
+};
+
+// Parallel single-source shortest paths by delta-stepping. Nodes wait in buckets of width
+// delta. The lowest bucket is emptied by relaxing the light roads (weight <= delta) of all its
+// nodes in parallel, repeatedly, since light roads can refill it; then the heavy roads of every
+// node it held are relaxed once, in parallel again. Each label packs distance and parent into
+// one 64-bit word, so a compare-and-swap keeps both consistent. Equal distances over a road of
+// positive weight resolve to the smaller parent, which makes the tree independent of thread
+// timing; over zero-weight roads that could close a cycle of parents, so those need a strictly
+// shorter distance and only there the first of several equal parents wins.
+class DeltaStepping {
+public:
+    static const int chunkSize = 256;  // Nodes per task; smaller frontiers run on the caller.
+
+    CSRGraph& graph;
+    bool ignoreBlocked;
+    int delta;
+    atomic<uint64_t>* labels = nullptr;
+    DynamicArray<DynamicArray<uint32_t>> buckets;  // Cyclic, enough for one heavy road ahead
+    DynamicArray<long long> bucketOf;              // Bucket a node is queued in, -1 if none
+    DynamicArray<DynamicArray<uint32_t>> improved; // Nodes improved by each chunk task
+    int queued = 0;
+
+    DeltaStepping(CSRGraph& graph, bool ignoreBlocked, int delta)
+        : graph(graph), ignoreBlocked(ignoreBlocked), delta(delta > 0 ? delta : autoDelta(graph)) {}
+
+    ~DeltaStepping() {
+        delete[] labels;
+    }
+
+    // Picks the average road weight, which keeps light phases short without making
+    // buckets so narrow that most of them are empty.
+    static int autoDelta(CSRGraph& graph) {
+        long long total = 0;
+        for (int e = 0; e < graph.edgeCount(); ++e) {
+            total += graph.weights[e];
+        }
+        long long average = graph.edgeCount() == 0 ? 1 : total / graph.edgeCount();
+        return average < 1 ? 1 : (int)average;
+    }
+
+    static uint64_t pack(int distance, uint32_t parent) {
+        return ((uint64_t)(uint32_t)distance << 32) | parent;
+    }
+
+    int distance(uint32_t node) {
+        uint64_t label = labels[node].load(memory_order_relaxed);
+        return label == UINT64_MAX ? INT_MAX : (int)(label >> 32);
+    }
+
+    // Lowers the label of node to (distance, parent) if that is smaller, or only if the
+    // distance is smaller when ties are not allowed. True if the distance went down.
+    bool improve(uint32_t node, int distance, uint32_t parent, bool allowTie) {
+        uint64_t candidate = pack(distance, parent);
+        uint64_t current = labels[node].load(memory_order_relaxed);
+        while (allowTie ? candidate < current : (candidate >> 32) < (current >> 32)) {
+            if (labels[node].compare_exchange_weak(current, candidate, memory_order_relaxed)) {
+                return (uint32_t)distance < (current >> 32);
+            }
+        }
+        return false;
+    }
+
+    // Relaxes the light or heavy roads of nodes[begin, end) and records improved nodes in out.
+    void relaxRange(DynamicArray<uint32_t>& nodes, int begin, int end, bool light, DynamicArray<uint32_t>& out) {
+        for (int i = begin; i < end; ++i) {
+            uint32_t u = nodes[i];
+            int d = distance(u);
+            for (uint32_t e = graph.offsets[u]; e < graph.offsets[u + 1]; ++e) {
+                if ((graph.weights[e] <= delta) != light || (!ignoreBlocked && graph.isBlocked(u, e))) continue;
+                uint32_t v = graph.targets[e];
+                if (improve(v, d + graph.weights[e], u, graph.weights[e] > 0)) {
+                    out.pushBack(v);
+                }
+            }
+        }
+    }
+
+    // Relaxes the roads of all nodes in parallel chunks, then files improved nodes into buckets.
+    void relax(DynamicArray<uint32_t>& nodes, bool light) {
+        int chunks = (nodes.size() + chunkSize - 1) / chunkSize;
+        if (improved.size() < chunks) improved.resize(chunks);
+        if (chunks <= 1) {
+            improved[0].clear();
+            relaxRange(nodes, 0, nodes.size(), light, improved[0]);
+        } else {
+            ThreadPool& pool = routingPool();
+            for (int c = 0; c < chunks; ++c) {
+                pool.submit([this, &nodes, light, c]() {
+                    int end = (c + 1) * chunkSize < nodes.size() ? (c + 1) * chunkSize : nodes.size();
+                    improved[c].clear();
+                    relaxRange(nodes, c * chunkSize, end, light, improved[c]);
+                });
+            }
+            pool.wait();
+        }
+        for (int c = 0; c < chunks; ++c) {
+            for (int i = 0; i < improved[c].size(); ++i) {
+                uint32_t v = improved[c][i];
+                long long bucket = distance(v) / delta;
+                if (bucketOf[v] != bucket) {
+                    bucketOf[v] = bucket;
+                    buckets[bucket % buckets.size()].pushBack(v);
+                    ++queued;
+                }
+            }
+        }
+    }
+
+    ShortestPathTree run(uint32_t source) {
+        int n = graph.nodeCount();
+        labels = new atomic<uint64_t>[n];
+        for (int i = 0; i < n; ++i) {
+            labels[i].store(UINT64_MAX, memory_order_relaxed);
+        }
+        buckets.resize(graph.maxWeight / delta + 2);
+        bucketOf.resize(n, -1);
+
+        labels[source].store(pack(0, NO_NODE));
+        bucketOf[source] = 0;
+        buckets[0].pushBack(source);
+        queued = 1;
+
+        DynamicArray<uint32_t> frontier;
+        DynamicArray<uint32_t> emptied;  // Every node taken from the current bucket
+        for (long long current = 0; queued > 0; ++current) {
+            DynamicArray<uint32_t>& bucket = buckets[current % buckets.size()];
+            emptied.clear();
+            while (!bucket.isEmpty()) {
+                frontier.clear();
+                for (int i = 0; i < bucket.size(); ++i) {
+                    uint32_t v = bucket[i];
+                    if (bucketOf[v] == current) {  // Other entries moved to a lower bucket since.
+                        bucketOf[v] = -1;
+                        frontier.pushBack(v);
+                        emptied.pushBack(v);
+                    }
+                }
+                queued -= bucket.size();
+                bucket.clear();
+                relax(frontier, true);
+            }
+            relax(emptied, false);
+        }
+
+        ShortestPathTree tree;
+        tree.source = source;
+        tree.distances.resize(n);
+        tree.parents.resize(n);
+        for (int i = 0; i < n; ++i) {
+            uint64_t label = labels[i].load(memory_order_relaxed);
+            tree.distances[i] = label == UINT64_MAX ? INT_MAX : (int)(label >> 32);
+            tree.parents[i] = label == UINT64_MAX ? NO_NODE : (uint32_t)label;
+        }
+        return tree;
+    }
+};
+
+// A shortest path tree that follows road changes (Ramalingam-Reps). A road that got cheaper
+// or reopened only lowers distances downstream of it, so a Dijkstra seeded at its end fixes
+// them. A road of the tree that got dearer or closed detaches the subtree below it; only those
+// nodes are reset, reattached through their cheapest incoming road from the rest of the tree,
+// and settled again. Everything outside the subtree keeps its distance.
+class DynamicShortestPaths {
+public:
+    bool ignoreBlocked = false;
+    ShortestPathTree tree;
+    DynamicArray<uint8_t> red;  // Signals as the tree last saw them, updated one node at a time
+    NodeHeap<> heap;
+    DynamicArray<uint32_t> detached;
+    int repaired = 0;  // Nodes settled by the last build or repair
+
+    DynamicShortestPaths(uint32_t source = NO_NODE, bool ignoreBlocked = false) : ignoreBlocked(ignoreBlocked) {
+        tree.source = source;
+    }
+
+    // Weight of a road leaving from under the tree's blocked-road policy, INT_MAX if it can't be used.
+    int usableWeight(CSRGraph& graph, uint32_t from, uint32_t slot) {
+        return !ignoreBlocked && (graph.isClosed(slot) || red[from]) ? INT_MAX : graph.weights[slot];
+    }
+
+    // Computes the whole tree from scratch.
+    void build(CSRGraph& graph) {
+        DeltaStepping search(graph, ignoreBlocked, 0);
+        tree = search.run(tree.source);
+        red.resize(graph.nodeCount());
+        for (int i = 0; i < graph.nodeCount(); ++i) {
+            red[i] = graph.isRed(i);
+        }
+        heap.positions.slots.resize(graph.nodeCount(), -1);
+        repaired = graph.nodeCount();
+    }
+
+    // Runs Dijkstra from the nodes waiting in the heap, lowering distances it can improve.
+    void settle(CSRGraph& graph) {
+        while (!heap.isEmpty()) {
+            MinHeapNode<uint32_t> current = heap.extractMin();
+            ++repaired;
+            for (uint32_t e = graph.offsets[current.id]; e < graph.offsets[current.id + 1]; ++e) {
+                int weight = usableWeight(graph, current.id, e);
+                uint32_t v = graph.targets[e];
+                if (weight != INT_MAX && current.priority + weight < tree.distances[v]) {
+                    tree.distances[v] = current.priority + weight;
+                    tree.parents[v] = current.id;
+                    heap.insert(v, tree.distances[v]);
+                }
+            }
+        }
+    }
+
+    // Updates the tree after the road in slot, leaving from, changed weight or blocked state.
+    void roadChanged(CSRGraph& graph, uint32_t from, uint32_t slot) {
+        uint32_t to = graph.targets[slot];
+        int weight = usableWeight(graph, from, slot);
+        long long through = tree.distances[from] == INT_MAX || weight == INT_MAX
+                                ? LLONG_MAX : (long long)tree.distances[from] + weight;
+        repaired = 0;
+        if (through < tree.distances[to]) {
+            tree.distances[to] = (int)through;
+            tree.parents[to] = from;
+            heap.insert(to, tree.distances[to]);
+            settle(graph);
+        } else if (tree.parents[to] == from && through > tree.distances[to]) {
+            detach(graph, to);
+            settle(graph);
+        }
+    }
+
+    // Updates the tree after the signal of node changed, one road at a time.
+    void signalChanged(CSRGraph& graph, uint32_t node) {
+        red[node] = graph.isRed(node);
+        for (uint32_t e = graph.offsets[node]; e < graph.offsets[node + 1]; ++e) {
+            roadChanged(graph, node, e);
+        }
+    }
+
+    // Resets the subtree below root and queues each of its nodes at its best distance through
+    // an incoming road from a node outside the subtree.
+    void detach(CSRGraph& graph, uint32_t root) {
+        detached.clear();
+        detached.pushBack(root);
+        for (int i = 0; i < detached.size(); ++i) {
+            uint32_t u = detached[i];
+            for (uint32_t e = graph.offsets[u]; e < graph.offsets[u + 1]; ++e) {
+                if (tree.parents[graph.targets[e]] == u) {
+                    detached.pushBack(graph.targets[e]);
+                }
+            }
+        }
+        for (int i = 0; i < detached.size(); ++i) {
+            tree.distances[detached[i]] = INT_MAX;
+            tree.parents[detached[i]] = NO_NODE;
+        }
+        // Nodes outside the subtree kept their distances, so every finite one is final.
+        for (int i = 0; i < detached.size(); ++i) {
+            uint32_t v = detached[i];
+            for (uint32_t r = graph.reverseOffsets[v]; r < graph.reverseOffsets[v + 1]; ++r) {
+                uint32_t u = graph.sources[r];
+                if (tree.distances[u] == INT_MAX || (!ignoreBlocked && ((graph.reverseFlags[r] & EDGE_BLOCKED) || red[u]))) continue;
+                int newDist = tree.distances[u] + graph.reverseWeights[r];
+                if (newDist < tree.distances[v]) {
+                    tree.distances[v] = newDist;
+                    tree.parents[v] = u;
+                }
+            }
+            if (tree.distances[v] != INT_MAX) {
+                heap.insert(v, tree.distances[v]);
+            }
+        }
+    }
+};
+
+// Lazily lists the loopless paths from source to target, depth first, within limits on cost,
+// roads per path and number of paths. The search keeps an explicit stack of frames, one per
+// node of the current path, and the path itself in one buffer that grows and shrinks with it,
+// so memory depends on the path length, not on how many paths there are. A branch is cut as
+// soon as its cost plus the remaining distance to target (toTarget) exceeds maxCost.
+// The snapshot must not change while paths are being listed.
+class PathEnumerator {
+public:
+    class Frame {
+    public:
+        uint32_t nextSlot;  // Next road of the frame's node to try
+        int cost;           // Cost of the path up to the frame's node
+
+        Frame(uint32_t nextSlot = 0, int cost = 0) : nextSlot(nextSlot), cost(cost) {}
+    };
+
+    CSRGraph& graph;
+    uint32_t target;
+    bool ignoreBlocked;
+    int maxCost;
+    int maxHops;
+    int maxPaths;
+    DynamicArray<int> toTarget;   // Lower bounds on the rest of the way, INT_MAX if there is none
+    DynamicArray<Frame> stack;
+    DynamicArray<uint32_t> path;  // Nodes of the current path, one per frame
+    DynamicArray<uint8_t> onPath;
+    int cost = 0;                 // Cost of the path last returned by next()
+    int found = 0;
+    bool started = false;
+    bool atTarget = false;        // The top frame is the target and must be left first
+
+    PathEnumerator(CSRGraph& graph, uint32_t source, uint32_t target, BlockedPolicy blockedPolicy,
+                   int maxCost = INT_MAX, int maxHops = INT_MAX, int maxPaths = INT_MAX)
+        : graph(graph), target(target), ignoreBlocked(blockedPolicy == IGNORE_BLOCKED),
+          maxCost(maxCost), maxHops(maxHops), maxPaths(maxPaths) {
+        onPath.resize(graph.nodeCount(), 0);
+        push(source, 0);
+    }
+
+    void push(uint32_t node, int pathCost) {
+        stack.pushBack(Frame(graph.offsets[node], pathCost));
+        path.pushBack(node);
+        onPath[node] = 1;
+    }
+
+    void pop() {
+        onPath[path.popBack()] = 0;
+        stack.popBack();
+    }
+
+    // Moves to the next path. Returns false once there are no more within the limits; the
+    // path and its cost are in path and cost otherwise.
+    bool next() {
+        if (found >= maxPaths) {
+            return false;
+        }
+        if (!started) {
+            started = true;
+            if (path[0] == target) {  // The only loopless path from a node to itself
+                atTarget = true;
+                cost = 0;
+                ++found;
+                return true;
+            }
+        }
+        if (atTarget) {
+            pop();
+            atTarget = false;
+        }
+        while (!stack.isEmpty()) {
+            uint32_t u = path[path.size() - 1];
+            Frame& frame = stack[stack.size() - 1];
+            if (frame.nextSlot == graph.offsets[u + 1] || path.size() > maxHops) {
+                pop();
+                continue;
+            }
+            uint32_t e = frame.nextSlot++;
+            uint32_t v = graph.targets[e];
+            if (onPath[v] || toTarget[v] == INT_MAX || (!ignoreBlocked && graph.isBlocked(u, e))) continue;
+            long long pathCost = (long long)frame.cost + graph.weights[e];
+            if (pathCost + toTarget[v] > maxCost) continue;
+            push(v, (int)pathCost);
+            if (v == target) {
+                atTarget = true;
+                cost = (int)pathCost;
+                ++found;
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+const uint64_t COUNT_SATURATED = UINT64_MAX; // Route count too large to hold, possibly unbounded.
+
+// Adds two route counts, sticking at COUNT_SATURATED instead of wrapping around.
+inline uint64_t saturatingAdd(uint64_t a, uint64_t b) {
+    return a > COUNT_SATURATED - b ? COUNT_SATURATED : a + b;
+}
+
+// Counts the routes from source to target that cost at most maxCost, without listing them:
+// dynamic programming over (node, cost spent). A route ends the first time it reaches the
+// target but may otherwise pass an intersection more than once. Costs are handled in
+// increasing order; the counts waiting at later costs sit in a ring of maxWeight + 1 lists,
+// so memory follows the pending entries rather than nodes times budget. Within one cost, the
+// intersections reached are ordered by a Tarjan pass over the zero-weight roads between them
+// and handled in topological order. A zero-weight cycle reached that way can be driven round
+// without end and still make the budget, so its intersections, and everything they lead to,
+// count as saturated; cycles no counted route reaches don't matter.
+// toTarget must hold lower bounds on the remaining distance; any state that can't reach the
+// target within budget is dropped, so a budget equal to the shortest distance leaves only
+// the roads of shortest routes.
+class RouteCounter {
+public:
+    class Entry {
+    public:
+        uint32_t node;
+        uint64_t count;
+
+        Entry(uint32_t node = 0, uint64_t count = 0) : node(node), count(count) {}
+    };
+
+    CSRGraph& graph;
+    bool ignoreBlocked;
+    DynamicArray<int> toTarget;
+    DynamicArray<DynamicArray<Entry>> pending; // Counts arriving at cost c, in list c % pending.size()
+    DynamicArray<uint64_t> counts;             // Counts of the cost being processed
+    DynamicArray<int> reachedAt;               // Last cost at which each node was reached
+    DynamicArray<int> doneAt;                  // Last cost at which each node was processed
+    DynamicArray<uint32_t> index;              // Tarjan number, NO_NODE once the component is known
+    DynamicArray<uint32_t> lowLink;
+    DynamicArray<uint8_t> looped;              // On a zero-weight cycle reached at this cost
+    DynamicArray<uint32_t> open;               // Tarjan's component stack
+    DynamicArray<uint32_t> path;               // Nodes whose roads are being explored
+    DynamicArray<uint32_t> nextSlots;
+    DynamicArray<uint32_t> sequence;           // Nodes reached at this cost, successors first
+
+    RouteCounter(CSRGraph& graph, BlockedPolicy blockedPolicy)
+        : graph(graph), ignoreBlocked(blockedPolicy == IGNORE_BLOCKED) {}
+
+    // True if the road at slot can be taken at cost reach and still end within budget.
+    bool keeps(uint32_t from, uint32_t slot, long long reach, int maxCost) {
+        int rest = toTarget[graph.targets[slot]];
+        return (ignoreBlocked || !graph.isBlocked(from, slot)) && rest != INT_MAX && reach + rest <= maxCost;
+    }
+
+    void discover(uint32_t node, uint32_t target, int now, uint32_t& counter) {
+        reachedAt[node] = now;
+        index[node] = lowLink[node] = counter++;
+        looped[node] = 0;
+        open.pushBack(node);
+        path.pushBack(node);
+        nextSlots.pushBack(node == target ? graph.offsets[node + 1] : graph.offsets[node]);
+    }
+
+    // Fills sequence with every node reached at cost now: the arrivals and whatever they reach
+    // over zero-weight roads. An iterative Tarjan pass emits the components successors first
+    // and marks the ones holding a cycle. Routes end at the target, so its roads are skipped.
+    void orderZeroWeightRoads(DynamicArray<Entry>& arrivals, uint32_t target, int now, int maxCost) {
+        sequence.clear();
+        uint32_t counter = 0;
+        for (int i = 0; i < arrivals.size(); ++i) {
+            if (reachedAt[arrivals[i].node] == now) continue;
+            discover(arrivals[i].node, target, now, counter);
+            while (!path.isEmpty()) {
+                uint32_t u = path.back();
+                uint32_t& e = nextSlots.back();
+                if (e < graph.offsets[u + 1]) {
+                    uint32_t slot = e++;
+                    if (graph.weights[slot] != 0 || !keeps(u, slot, now, maxCost)) continue;
+                    uint32_t v = graph.targets[slot];
+                    if (v == u) {
+                        looped[u] = 1;
+                    } else if (reachedAt[v] != now) {
+                        discover(v, target, now, counter);
+                    } else if (index[v] != NO_NODE && index[v] < lowLink[u]) {
+                        lowLink[u] = index[v];
+                    }
+                    continue;
+                }
+                path.popBack();
+                nextSlots.popBack();
+                if (!path.isEmpty() && lowLink[u] < lowLink[path.back()]) {
+                    lowLink[path.back()] = lowLink[u];
+                }
+                if (lowLink[u] == index[u]) {
+                    int first = sequence.size();
+                    uint32_t v;
+                    do {
+                        v = open.popBack();
+                        sequence.pushBack(v);
+                    } while (v != u);
+                    uint8_t cycle = sequence.size() - first > 1 || looped[u];
+                    for (int m = first; m < sequence.size(); ++m) {
+                        index[sequence[m]] = NO_NODE;
+                        looped[sequence[m]] = cycle;
+                    }
+                }
+            }
+        }
+    }
+
+    uint64_t count(uint32_t source, uint32_t target, int maxCost) {
+        int n = graph.nodeCount();
+        if (maxCost < 0 || toTarget[source] > maxCost) return 0;
+        pending.resize(graph.maxWeight + 1);
+        counts.resize(n, 0);
+        reachedAt.resize(n, -1);
+        doneAt.resize(n, -1);
+        index.resize(n, NO_NODE);
+        lowLink.resize(n, 0);
+        looped.resize(n, 0);
+
+        uint64_t total = 0;
+        int waiting = 1;  // Entries in pending
+        pending[0].pushBack(Entry(source, 1));
+        for (int cost = 0; cost <= maxCost && waiting > 0; ++cost) {
+            DynamicArray<Entry>& arrivals = pending[cost % pending.size()];
+            waiting -= arrivals.size();
+            for (int i = 0; i < arrivals.size(); ++i) {
+                counts[arrivals[i].node] = saturatingAdd(counts[arrivals[i].node], arrivals[i].count);
+            }
+            orderZeroWeightRoads(arrivals, target, cost, maxCost);
+            arrivals.clear();
+
+            for (int i = sequence.size() - 1; i >= 0; --i) {
+                uint32_t u = sequence[i];
+                uint64_t routes = looped[u] ? COUNT_SATURATED : counts[u];
+                counts[u] = 0;
+                doneAt[u] = cost;
+                if (u == target) {
+                    total = saturatingAdd(total, routes);
+                    continue;
+                }
+                for (uint32_t e = graph.offsets[u]; e < graph.offsets[u + 1]; ++e) {
+                    uint32_t v = graph.targets[e];
+                    long long reach = (long long)cost + graph.weights[e];
+                    if (!keeps(u, e, reach, maxCost)) continue;
+                    if (reach > cost) {
+                        pending[reach % pending.size()].pushBack(Entry(v, routes));
+                        ++waiting;
+                    } else if (doneAt[v] != cost) {
+                        counts[v] = saturatingAdd(counts[v], routes);  // Later in this cost's order
+                    }
+                }
+            }
+        }
+        for (int i = 0; i < pending.size(); ++i) {
+            pending[i].clear();
+        }
+        return total;
+    }
+};
+
+// Direction-optimizing breadth first search (Beamer et al.). Small frontiers expand top-down
+// over their own roads. Once the frontier's roads outnumber the unexplored roads divided by
+// alpha, every unvisited node instead scans its incoming roads bottom-up and stops at the
+// first parent on the frontier. The search goes back to top-down when the frontier shrinks
+// below the node count divided by beta.
+class BreadthFirstSearch {
+public:
+    CSRGraph& graph;
+    bool ignoreBlocked;
+    int alpha = 14;
+    int beta = 24;
+    DynamicArray<int> levels;       // Hops from the source, INT_MAX if unreachable
+    DynamicArray<uint32_t> parents; // Node the search reached each node from
+    DenseBitset visited;
+    DenseBitset inFrontier;
+    DynamicArray<uint32_t> frontier;
+    DynamicArray<uint32_t> next;
+    int bottomUpLevels = 0;
+
+    BreadthFirstSearch(CSRGraph& graph, BlockedPolicy blockedPolicy)
+        : graph(graph), ignoreBlocked(blockedPolicy == IGNORE_BLOCKED) {}
+
+    long long roadsOf(DynamicArray<uint32_t>& nodes) {
+        long long roads = 0;
+        for (int i = 0; i < nodes.size(); ++i) {
+            roads += graph.offsets[nodes[i] + 1] - graph.offsets[nodes[i]];
+        }
+        return roads;
+    }
+
+    void reach(uint32_t node, uint32_t parent, int level) {
+        visited.set(node);
+        levels[node] = level;
+        parents[node] = parent;
+        next.pushBack(node);
+    }
+
+    void topDown(int level) {
+        for (int i = 0; i < frontier.size(); ++i) {
+            uint32_t u = frontier[i];
+            for (uint32_t e = graph.offsets[u]; e < graph.offsets[u + 1]; ++e) {
+                uint32_t v = graph.targets[e];
+                if (visited.test(v) || (!ignoreBlocked && graph.isBlocked(u, e))) continue;
+                reach(v, u, level);
+            }
+        }
+    }
+
+    void bottomUp(int level) {
+        int n = graph.nodeCount();
+        inFrontier.reset(n);
+        for (int i = 0; i < frontier.size(); ++i) {
+            inFrontier.set(frontier[i]);
+        }
+        for (int v = 0; v < n; ++v) {
+            if (visited.test(v)) continue;
+            for (uint32_t r = graph.reverseOffsets[v]; r < graph.reverseOffsets[v + 1]; ++r) {
+                uint32_t u = graph.sources[r];
+                if (!inFrontier.test(u) || (!ignoreBlocked && ((graph.reverseFlags[r] & EDGE_BLOCKED) || graph.isRed(u)))) continue;
+                reach(v, u, level);
+                break;
+            }
+        }
+    }
+
+    // Fills levels and parents for every node reachable from source.
+    void run(uint32_t source) {
+        int n = graph.nodeCount();
+        levels.resize(n);
+        levels.fill(INT_MAX);
+        parents.resize(n);
+        parents.fill(NO_NODE);
+        visited.reset(n);
+        frontier.clear();
+        next.clear();
+        bottomUpLevels = 0;
+
+        reach(source, NO_NODE, 0);
+        frontier.swapWith(next);
+        long long unexplored = (long long)graph.targets.size() - roadsOf(frontier);
+        bool goingUp = false;
+        for (int level = 1; !frontier.isEmpty(); ++level) {
+            long long frontierRoads = roadsOf(frontier);
+            if (!goingUp && frontierRoads > unexplored / alpha) {
+                goingUp = true;
+            } else if (goingUp && frontier.size() < n / beta) {
+                goingUp = false;
+            }
+            next.clear();
+            if (goingUp) {
+                bottomUp(level);
+                ++bottomUpLevels;
+            } else {
+                topDown(level);
+            }
+            unexplored -= roadsOf(next);
+            frontier.swapWith(next);
+        }
+    }
+};
+
+// Breadth first search from up to 64 sources at once. Bit i of a node's word stands for
+// source i: seen holds the sources that reached the node, frontier those that reached it at
+// the last level. Scanning a frontier node's roads once moves all of its bits together, so
+// a batch costs about as much as a few single-source searches.
+class MultiSourceBfs {
+public:
+    static const int width = 64;
+    CSRGraph& graph;
+    bool ignoreBlocked;
+    DynamicArray<uint64_t> seen;
+    DynamicArray<uint64_t> frontier;
+    DynamicArray<uint64_t> next;
+    DynamicArray<uint32_t> active;   // Nodes with frontier bits
+    DynamicArray<uint32_t> touched;  // Nodes with next bits
+
+    MultiSourceBfs(CSRGraph& graph, BlockedPolicy blockedPolicy)
+        : graph(graph), ignoreBlocked(blockedPolicy == IGNORE_BLOCKED) {}
+
+    // Runs rows [firstRow, firstRow + count) of a hop table whose columns are listed per node
+    // by firstColumn and nextColumn, and stores every hop count that is reached.
+    void run(const MatrixQuery& query, int firstRow, int count, DynamicArray<int>& firstColumn,
+             DynamicArray<int>& nextColumn, DistanceMatrix& hops) {
+        int n = graph.nodeCount();
+        seen.resize(n);
+        seen.fill(0);
+        frontier.resize(n);
+        frontier.fill(0);
+        next.resize(n);
+        next.fill(0);
+        active.clear();
+        for (int i = 0; i < count; ++i) {
+            uint32_t source = query.sources[firstRow + i];
+            if (source >= (uint32_t)n) continue;
+            if (seen[source] == 0) active.pushBack(source);
+            seen[source] |= uint64_t(1) << i;
+        }
+        for (int a = 0; a < active.size(); ++a) {
+            frontier[active[a]] = seen[active[a]];
+            record(active[a], seen[active[a]], 0, firstRow, firstColumn, nextColumn, hops);
+        }
+        for (int level = 1; !active.isEmpty(); ++level) {
+            touched.clear();
+            for (int a = 0; a < active.size(); ++a) {
+                uint32_t u = active[a];
+                uint64_t bits = frontier[u];
+                frontier[u] = 0;
+                for (uint32_t e = graph.offsets[u]; e < graph.offsets[u + 1]; ++e) {
+                    uint32_t v = graph.targets[e];
+                    uint64_t arriving = bits & ~seen[v];
+                    if (arriving == 0 || (!ignoreBlocked && graph.isBlocked(u, e))) continue;
+                    if (next[v] == 0) touched.pushBack(v);
+                    next[v] |= arriving;
+                }
+            }
+            for (int t = 0; t < touched.size(); ++t) {
+                uint32_t v = touched[t];
+                seen[v] |= next[v];
+                frontier[v] = next[v];
+                record(v, next[v], level, firstRow, firstColumn, nextColumn, hops);
+                next[v] = 0;
+            }
+            active.swapWith(touched);
+        }
+    }
+
+    void record(uint32_t node, uint64_t bits, int level, int firstRow, DynamicArray<int>& firstColumn,
+                DynamicArray<int>& nextColumn, DistanceMatrix& hops) {
+        if (firstColumn[node] < 0) return;
+        while (bits) {
+            int row = firstRow + __builtin_ctzll(bits);
+            bits &= bits - 1;
+            for (int c = firstColumn[node]; c >= 0; c = nextColumn[c]) {
+                hops.cost(row, c) = level;
+            }
+        }
+    }
+};
+
+// Strongly connected components plus interval labels over their condensation (GRAIL), for
+// rejecting unreachable pairs before a search starts. Tarjan numbers components sinks first,
+// so a component only reaches components with smaller numbers. Each labeling gives every
+// component an interval that contains the intervals of all components it reaches; a pair
+// whose intervals don't nest in some labeling is unreachable. Nested intervals only mean
+// "maybe", and the search decides. Closed roads count unless ignoreBlocked; signals never
+// count, since a red light only holds traffic for a while.
+class ReachabilityIndex {
+public:
+    static const int labelings = 2;
+    bool ignoreBlocked = false;
+    DynamicArray<uint32_t> component;      // Component of every node
+    DynamicArray<uint32_t> members;        // Nodes grouped by component
+    DynamicArray<uint32_t> memberOffsets;  // Start of each component in members
+    DynamicArray<uint32_t> ranks[labelings];
+    DynamicArray<uint32_t> lows[labelings];
+
+    int componentCount() {
+        return memberOffsets.size() - 1;
+    }
+
+    bool usable(CSRGraph& graph, uint32_t slot) {
+        return ignoreBlocked || !(graph.flags[slot] & EDGE_BLOCKED);
+    }
+
+    // False only if no route from source to target can exist. O(labelings).
+    bool mayReach(uint32_t source, uint32_t target) {
+        uint32_t from = component[source];
+        uint32_t to = component[target];
+        if (from == to) return true;
+        if (from < to) return false;
+        for (int k = 0; k < labelings; ++k) {
+            if (lows[k][to] < lows[k][from] || ranks[k][to] > ranks[k][from]) return false;
+        }
+        return true;
+    }
+
+    // True if the labels stay valid once the road from -> to is closed. Labels may then
+    // claim too much, which is safe, but a component the road held together can split.
+    bool survivesClosing(uint32_t from, uint32_t to) {
+        return component[from] != component[to];
+    }
+
+    // True if the labels stay valid once the road from -> to is reopened: every
+    // component that now reaches further already nested the new targets.
+    bool survivesOpening(uint32_t from, uint32_t to) {
+        return mayReach(from, to);
+    }
+
+    void build(CSRGraph& graph, bool ignoreBlockedRoads) {
+        ignoreBlocked = ignoreBlockedRoads;
+        findComponents(graph);
+        int count = componentCount();
+        // Labeling 0 ranks components by their Tarjan number.
+        ranks[0].resize(count);
+        for (int c = 0; c < count; ++c) {
+            ranks[0][c] = c;
+        }
+        // Labeling 1 ranks them by Kahn's algorithm over the reverse roads, sinks first,
+        // taking the latest ready component so it explores in a different order.
+        DynamicArray<uint32_t> outDegree(count, 0);
+        for (int u = 0; u < graph.nodeCount(); ++u) {
+            for (uint32_t e = graph.offsets[u]; e < graph.offsets[u + 1]; ++e) {
+                if (usable(graph, e) && component[graph.targets[e]] != component[u]) ++outDegree[component[u]];
+            }
+        }
+        DynamicArray<uint32_t> ready;
+        for (int c = 0; c < count; ++c) {
+            if (outDegree[c] == 0) ready.pushBack(c);
+        }
+        ranks[1].resize(count);
+        uint32_t next = 0;
+        while (!ready.isEmpty()) {
+            uint32_t c = ready.popBack();
+            ranks[1][c] = next++;
+            for (uint32_t m = memberOffsets[c]; m < memberOffsets[c + 1]; ++m) {
+                uint32_t v = members[m];
+                for (uint32_t r = graph.reverseOffsets[v]; r < graph.reverseOffsets[v + 1]; ++r) {
+                    uint32_t before = component[graph.sources[r]];
+                    if ((!ignoreBlocked && (graph.reverseFlags[r] & EDGE_BLOCKED)) || before == c) continue;
+                    if (--outDegree[before] == 0) ready.pushBack(before);
+                }
+            }
+        }
+        // A component's interval runs from the lowest rank it reaches to its own rank. In
+        // both rankings successors come first, so one pass in rank order fills the lows.
+        DynamicArray<uint32_t> byRank(count);
+        for (int k = 0; k < labelings; ++k) {
+            for (int c = 0; c < count; ++c) {
+                byRank[ranks[k][c]] = c;
+            }
+            lows[k] = ranks[k];
+            for (int i = 0; i < count; ++i) {
+                uint32_t c = byRank[i];
+                for (uint32_t m = memberOffsets[c]; m < memberOffsets[c + 1]; ++m) {
+                    uint32_t u = members[m];
+                    for (uint32_t e = graph.offsets[u]; e < graph.offsets[u + 1]; ++e) {
+                        uint32_t after = component[graph.targets[e]];
+                        if (usable(graph, e) && lows[k][after] < lows[k][c]) lows[k][c] = lows[k][after];
+                    }
+                }
+            }
+        }
+    }
+
+    // Iterative Tarjan: an explicit stack of (node, next road) replaces the recursion, so
+    // long chains of roads can't overflow the call stack. A node is on the component stack
+    // exactly while it has an index but no component yet.
+    void findComponents(CSRGraph& graph) {
+        int n = graph.nodeCount();
+        component.resize(n);
+        component.fill(NO_NODE);
+        members.clear();
+        memberOffsets.clear();
+        memberOffsets.pushBack(0);
+        DynamicArray<uint32_t> index(n, NO_NODE);
+        DynamicArray<uint32_t> lowLink(n, 0);
+        DynamicArray<uint32_t> open;      // Tarjan's component stack
+        DynamicArray<uint32_t> path;      // Nodes whose roads are being explored
+        DynamicArray<uint32_t> nextSlots;
+        uint32_t counter = 0;
+        for (int root = 0; root < n; ++root) {
+            if (index[root] != NO_NODE) continue;
+            index[root] = lowLink[root] = counter++;
+            open.pushBack(root);
+            path.pushBack(root);
+            nextSlots.pushBack(graph.offsets[root]);
+            while (!path.isEmpty()) {
+                uint32_t u = path.back();
+                uint32_t& e = nextSlots.back();
+                if (e < graph.offsets[u + 1]) {
+                    uint32_t slot = e++;
+                    if (!usable(graph, slot)) continue;
+                    uint32_t v = graph.targets[slot];
+                    if (index[v] == NO_NODE) {
+                        index[v] = lowLink[v] = counter++;
+                        open.pushBack(v);
+                        path.pushBack(v);
+                        nextSlots.pushBack(graph.offsets[v]);
+                    } else if (component[v] == NO_NODE && index[v] < lowLink[u]) {
+                        lowLink[u] = index[v];
+                    }
+                    continue;
+                }
+                path.popBack();
+                nextSlots.popBack();
+                if (!path.isEmpty() && lowLink[u] < lowLink[path.back()]) {
+                    lowLink[path.back()] = lowLink[u];
+                }
+                if (lowLink[u] == index[u]) {
+                    uint32_t id = memberOffsets.size() - 1;
+                    uint32_t v;
+                    do {
+                        v = open.popBack();
+                        component[v] = id;
+                        members.pushBack(v);
+                    } while (v != u);
+                    memberOffsets.pushBack(members.size());
+                }
+            }
+        }
+    }
+};
+
+// Dominator tree of the intersections reachable from root over open roads (closures count,
+// signals don't): d dominates v if every route from root to v passes d. Closing the road
+// root -> to cuts off exactly the intersections to dominates, unless another open road into
+// to can still be reached without passing to. Built by the iterative algorithm of Cooper,
+// Harvey and Kennedy over a reverse postorder from an explicit-stack DFS.
+// This replaces an index of bridges and articulation points over the street layout. With
+// one-way roads, an undirected bridge says nothing about who can still reach whom. The
+// directed equivalent (strong bridges) only covers strongly connected parts of the city.
+// So the tree is built per root, and impact is counted from the closing road's start.
+// One tree costs a DFS and a few passes over the roads root reaches.
+class DominatorTree {
+public:
+    uint32_t root = NO_NODE;
+    DynamicArray<uint32_t> order;         // Reachable nodes in reverse postorder
+    DynamicArray<uint32_t> postNumbers;   // Postorder number, NO_NODE if unreachable
+    DynamicArray<uint32_t> dominators;    // Immediate dominator, the root for itself
+    DynamicArray<uint32_t> subtreeSizes;  // Nodes each node dominates, itself included
+
+    bool reaches(uint32_t node) {
+        return postNumbers[node] != NO_NODE;
+    }
+
+    // Walks up the tree from node; true if dominator is on the way to the root.
+    bool dominates(uint32_t dominator, uint32_t node) {
+        while (node != root && node != dominator) {
+            node = dominators[node];
+        }
+        return node == dominator;
+    }
+
+    // Nodes root can no longer reach once the road in slot (leaving root) closes; 0 if the
+    // road is already closed.
+    uint32_t cutOffByRoad(CSRGraph& graph, uint32_t slot) {
+        uint32_t to = graph.targets[slot];
+        if (graph.isClosed(slot) || to == root) return 0;
+        for (uint32_t r = graph.reverseOffsets[to]; r < graph.reverseOffsets[to + 1]; ++r) {
+            uint32_t from = graph.sources[r];
+            if ((graph.reverseFlags[r] & EDGE_BLOCKED) || from == root || !reaches(from)) continue;
+            if (!dominates(to, from)) return 0;  // A detour into to survives the closure.
+        }
+        return subtreeSizes[to];
+    }
+
+    // Returns the nearest common dominator of a and b.
+    uint32_t intersect(uint32_t a, uint32_t b) {
+        while (a != b) {
+            while (postNumbers[a] < postNumbers[b]) a = dominators[a];
+            while (postNumbers[b] < postNumbers[a]) b = dominators[b];
+        }
+        return a;
+    }
+
+    void build(CSRGraph& graph, uint32_t source) {
+        int n = graph.nodeCount();
+        root = source;
+        postNumbers.resize(n);
+        postNumbers.fill(NO_NODE);
+        dominators.resize(n);
+        dominators.fill(NO_NODE);
+        subtreeSizes.resize(n);
+        subtreeSizes.fill(1);
+
+        // Postorder by an iterative DFS; visited nodes get a placeholder number until finished.
+        DynamicArray<uint32_t> postorder;
+        DynamicArray<uint32_t> path;
+        DynamicArray<uint32_t> nextSlots;
+        postNumbers[root] = 0;
+        path.pushBack(root);
+        nextSlots.pushBack(graph.offsets[root]);
+        while (!path.isEmpty()) {
+            uint32_t u = path.back();
+            uint32_t& e = nextSlots.back();
+            if (e < graph.offsets[u + 1]) {
+                uint32_t slot = e++;
+                uint32_t v = graph.targets[slot];
+                if (!graph.isClosed(slot) && postNumbers[v] == NO_NODE) {
+                    postNumbers[v] = 0;
+                    path.pushBack(v);
+                    nextSlots.pushBack(graph.offsets[v]);
+                }
+                continue;
+            }
+            path.popBack();
+            nextSlots.popBack();
+            postNumbers[u] = postorder.size();
+            postorder.pushBack(u);
+        }
+        order.clear();
+        for (int i = postorder.size() - 1; i >= 0; --i) {
+            order.pushBack(postorder[i]);
+        }
+
+        // Each pass moves every immediate dominator guess up to the common dominator of the
+        // processed predecessors, until nothing changes.
+        dominators[root] = root;
+        bool changed = true;
+        while (changed) {
+            changed = false;
+            for (int i = 1; i < order.size(); ++i) {
+                uint32_t v = order[i];
+                uint32_t best = NO_NODE;
+                for (uint32_t r = graph.reverseOffsets[v]; r < graph.reverseOffsets[v + 1]; ++r) {
+                    uint32_t from = graph.sources[r];
+                    if ((graph.reverseFlags[r] & EDGE_BLOCKED) || dominators[from] == NO_NODE) continue;
+                    best = best == NO_NODE ? from : intersect(from, best);
+                }
+                if (best != dominators[v]) {
+                    dominators[v] = best;
+                    changed = true;
+                }
+            }
+        }
+
+        // Dominators come before the nodes they dominate in reverse postorder.
+        for (int i = order.size() - 1; i > 0; --i) {
+            subtreeSizes[dominators[order[i]]] += subtreeSizes[order[i]];
+        }
+    }
+};
+
+// An arc of the contraction hierarchy. middle is the node a shortcut bypasses, or
+// NO_NODE for an original road.
+class HierarchyArc {
+public:
+    uint32_t node;
+    int weight;
+    uint32_t middle;
+
+    HierarchyArc(uint32_t node = NO_NODE, int weight = 0, uint32_t middle = NO_NODE)
+        : node(node), weight(weight), middle(middle) {}
+};
+
+// A shortcut found while contracting a node.
+class Shortcut {
+public:
+    uint32_t from;
+    uint32_t to;
+    int weight;
+
+    Shortcut(uint32_t from = NO_NODE, uint32_t to = NO_NODE, int weight = 0) : from(from), to(to), weight(weight) {}
+};
+
+// Contraction hierarchy of one snapshot. Nodes are contracted in rounds: every round takes the
+// nodes whose priority (shortcuts added minus roads removed, plus neighbours already contracted)
+// is lower than that of all their remaining neighbours, contracts them in parallel, and adds a
+// shortcut u -> w for a neighbour pair around a contracted node v unless a witness path that
+// avoids every node of the round is at least as short. A query then only ever goes up in rank.
+class ContractionHierarchy {
+public:
+    static const int witnessSettleLimit = 500;
+
+    DynamicArray<uint32_t> rank;          // Position of every node in the contraction order
+    DynamicArray<uint32_t> upOffsets;     // Arcs u -> v with rank[v] > rank[u], stored at u
+    DynamicArray<HierarchyArc> upArcs;
+    DynamicArray<uint32_t> downOffsets;   // Arcs v -> u with rank[v] > rank[u], stored at u
+    DynamicArray<HierarchyArc> downArcs;
+    int shortcuts = 0;
+    double buildMillis = 0;
+
+    // Working graph while building: arcs may still point at contracted nodes until compacted.
+    DynamicArray<DynamicArray<HierarchyArc>> out;
+    DynamicArray<DynamicArray<HierarchyArc>> in;
+    DynamicArray<uint8_t> state;          // 0 remaining, 1 contracting this round, 2 contracted
+    DynamicArray<int> priority;
+    DynamicArray<int> deletedNeighbors;
+
+    // Builds the hierarchy over every road of graph. Closures and signals are left out, so the
+    // hierarchy only goes stale when the roads or their weights change.
+    void build(CSRGraph& graph) {
+        chrono::steady_clock::time_point started = chrono::steady_clock::now();
+        int n = graph.nodeCount();
+        out.clear();
+        in.clear();
+        out.resize(n);
+        in.resize(n);
+        for (int u = 0; u < n; ++u) {
+            for (uint32_t e = graph.offsets[u]; e < graph.offsets[u + 1]; ++e) {
+                if (graph.targets[e] != (uint32_t)u) {
+                    out[u].pushBack(HierarchyArc(graph.targets[e], graph.weights[e]));
+                    in[graph.targets[e]].pushBack(HierarchyArc(u, graph.weights[e]));
+                }
+            }
+        }
+        rank.resize(n);
+        state.resize(n);
+        state.fill(0);
+        priority.resize(n);
+        deletedNeighbors.resize(n);
+        deletedNeighbors.fill(0);
+
+        DynamicArray<QueryWorkspace> workspaces(workerCount());
+        DynamicArray<DynamicArray<Shortcut>> scratch(workerCount());
+        parallelFor(n, [&](int u, int worker) {
+            priority[u] = simulate(u, workspaces[worker], scratch[worker]);
+        });
+
+        DynamicArray<uint32_t> remaining(n);
+        for (int u = 0; u < n; ++u) {
+            remaining[u] = u;
+        }
+        DynamicArray<uint8_t> selected;
+        DynamicArray<uint32_t> round;
+        DynamicArray<DynamicArray<Shortcut>> found;
+        DynamicArray<uint32_t> touched;
+        DynamicArray<uint8_t> isTouched(n, 0);
+        uint32_t nextRank = 0;
+
+        while (!remaining.isEmpty()) {
+            selected.resize(remaining.size());
+            parallelFor(remaining.size(), [&](int i, int) {
+                selected[i] = isLocalMinimum(remaining[i]);
+            });
+            round.clear();
+            for (int i = 0; i < remaining.size(); ++i) {
+                if (selected[i]) {
+                    round.pushBack(remaining[i]);
+                    state[remaining[i]] = 1;
+                }
+            }
+
+            found.resize(round.size());
+            parallelFor(round.size(), [&](int i, int worker) {
+                found[i].clear();
+                contract(round[i], workspaces[worker], found[i]);
+            });
+
+            // Contracted nodes keep their arcs to remaining nodes as their final up and down arcs.
+            touched.clear();
+            for (int i = 0; i < round.size(); ++i) {
+                uint32_t u = round[i];
+                rank[u] = nextRank++;
+                keepRemaining(out[u]);
+                keepRemaining(in[u]);
+                markNeighbors(out[u], touched, isTouched);
+                markNeighbors(in[u], touched, isTouched);
+            }
+            for (int i = 0; i < round.size(); ++i) {
+                state[round[i]] = 2;
+            }
+            for (int i = 0; i < round.size(); ++i) {
+                for (int j = 0; j < found[i].size(); ++j) {
+                    Shortcut& shortcut = found[i][j];
+                    addArc(out[shortcut.from], shortcut.to, shortcut.weight, round[i]);
+                    addArc(in[shortcut.to], shortcut.from, shortcut.weight, round[i]);
+                }
+            }
+            for (int i = 0; i < touched.size(); ++i) {
+                uint32_t v = touched[i];
+                isTouched[v] = 0;
+                keepRemaining(out[v]);
+                keepRemaining(in[v]);
+            }
+            parallelFor(touched.size(), [&](int i, int worker) {
+                uint32_t v = touched[i];
+                priority[v] = simulate(v, workspaces[worker], scratch[worker]);
+            });
+
+            int kept = 0;
+            for (int i = 0; i < remaining.size(); ++i) {
+                if (state[remaining[i]] == 0) {
+                    remaining[kept++] = remaining[i];
+                }
+            }
+            remaining.resize(kept);
+        }
+
+        freeze(out, upOffsets, upArcs);
+        freeze(in, downOffsets, downArcs);
+        out.clear();
+        in.clear();
+        shortcuts = 0;
+        for (int i = 0; i < upArcs.size(); ++i) {
+            if (upArcs[i].middle != NO_NODE) ++shortcuts;
+        }
+        for (int i = 0; i < downArcs.size(); ++i) {
+            if (downArcs[i].middle != NO_NODE) ++shortcuts;
+        }
+        buildMillis = chrono::duration<double, milli>(chrono::steady_clock::now() - started).count();
+    }
+
+    // True if u has a lower (priority, index) than every remaining neighbour.
+    bool isLocalMinimum(uint32_t u) {
+        for (int pass = 0; pass < 2; ++pass) {
+            DynamicArray<HierarchyArc>& arcs = pass == 0 ? out[u] : in[u];
+            for (int i = 0; i < arcs.size(); ++i) {
+                uint32_t v = arcs[i].node;
+                if (priority[v] < priority[u] || (priority[v] == priority[u] && v < u)) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    // Contraction priority of u, from a trial contraction.
+    int simulate(uint32_t u, QueryWorkspace& workspace, DynamicArray<Shortcut>& found) {
+        found.clear();
+        contract(u, workspace, found);
+        return 2 * found.size() - out[u].size() - in[u].size() + deletedNeighbors[u];
+    }
+
+    // Collects the shortcuts needed to remove u. Witness searches only pass through
+    // remaining nodes, so nodes contracted in the same round never vouch for each other.
+    void contract(uint32_t u, QueryWorkspace& workspace, DynamicArray<Shortcut>& found) {
+        for (int i = 0; i < in[u].size(); ++i) {
+            uint32_t from = in[u][i].node;
+            int toU = in[u][i].weight;
+            int maxOut = -1;
+            for (int j = 0; j < out[u].size(); ++j) {
+                if (out[u][j].node != from && out[u][j].weight > maxOut) maxOut = out[u][j].weight;
+            }
+            if (maxOut < 0) continue;
+            witnessSearch(from, u, toU + maxOut, workspace);
+            for (int j = 0; j < out[u].size(); ++j) {
+                uint32_t to = out[u][j].node;
+                int viaU = toU + out[u][j].weight;
+                if (to != from && viaU < workspace.distance(to)) {
+                    found.pushBack(Shortcut(from, to, viaU));
+                }
+            }
+        }
+    }
+
+    // Bounded Dijkstra from source among remaining nodes other than u. Stops once every
+    // out-neighbour of u is settled or nothing within maxDistance is left.
+    void witnessSearch(uint32_t source, uint32_t u, int maxDistance, QueryWorkspace& workspace) {
+        workspace.reset(out.size());
+        NodeHeap<>& pq = workspace.heap;
+        workspace.set(source, 0, NO_NODE);
+        pq.insert(source, 0);
+        int targetsLeft = 0;
+        for (int j = 0; j < out[u].size(); ++j) {
+            if (out[u][j].node != source) ++targetsLeft;
+        }
+        int settled = 0;
+        while (!pq.isEmpty()) {
+            MinHeapNode<uint32_t> current = pq.extractMin();
+            if (current.priority > maxDistance || ++settled > witnessSettleLimit) break;
+            for (int j = 0; j < out[u].size(); ++j) {
+                if (out[u][j].node == current.id && current.id != source) --targetsLeft;
+            }
+            if (targetsLeft == 0) break;
+            DynamicArray<HierarchyArc>& arcs = out[current.id];
+            for (int i = 0; i < arcs.size(); ++i) {
+                uint32_t next = arcs[i].node;
+                if (next == u || state[next] != 0) continue;
+                int newDist = current.priority + arcs[i].weight;
+                if (newDist < workspace.distance(next)) {
+                    workspace.set(next, newDist, current.id);
+                    pq.insert(next, newDist);
+                }
+            }
+        }
+    }
+
+    // Drops arcs that lead to nodes no longer remaining.
+    void keepRemaining(DynamicArray<HierarchyArc>& arcs) {
+        int kept = 0;
+        for (int i = 0; i < arcs.size(); ++i) {
+            if (state[arcs[i].node] == 0) {
+                arcs[kept++] = arcs[i];
+            }
+        }
+        arcs.resize(kept);
+    }
+
+    // Records the neighbours of a contracted node, which lose a road and need a new priority.
+    void markNeighbors(DynamicArray<HierarchyArc>& arcs, DynamicArray<uint32_t>& touched, DynamicArray<uint8_t>& isTouched) {
+        for (int i = 0; i < arcs.size(); ++i) {
+            uint32_t v = arcs[i].node;
+            ++deletedNeighbors[v];
+            if (!isTouched[v]) {
+                isTouched[v] = 1;
+                touched.pushBack(v);
+            }
+        }
+    }
+
+    // Adds an arc, or shortens the existing arc to the same node.
+    static void addArc(DynamicArray<HierarchyArc>& arcs, uint32_t node, int weight, uint32_t middle) {
+        for (int i = 0; i < arcs.size(); ++i) {
+            if (arcs[i].node == node) {
+                if (weight < arcs[i].weight) {
+                    arcs[i] = HierarchyArc(node, weight, middle);
+                }
+                return;
+            }
+        }
+        arcs.pushBack(HierarchyArc(node, weight, middle));
+    }
+
+    // Packs per-node arc lists into offset and arc arrays.
+    static void freeze(DynamicArray<DynamicArray<HierarchyArc>>& lists, DynamicArray<uint32_t>& offsets, DynamicArray<HierarchyArc>& arcs) {
+        offsets.resize(lists.size() + 1);
+        arcs.clear();
+        for (int u = 0; u < lists.size(); ++u) {
+            offsets[u] = arcs.size();
+            for (int i = 0; i < lists[u].size(); ++i) {
+                arcs.pushBack(lists[u][i]);
+            }
+        }
+        offsets[lists.size()] = arcs.size();
+    }
+
+    // Returns the arc to node stored at u, or nullptr.
+    static HierarchyArc* findArc(DynamicArray<uint32_t>& offsets, DynamicArray<HierarchyArc>& arcs, uint32_t u, uint32_t node) {
+        for (uint32_t a = offsets[u]; a < offsets[u + 1]; ++a) {
+            if (arcs[a].node == node) {
+                return &arcs[a];
+            }
+        }
+        return nullptr;
+    }
+
+    // Appends the original nodes after from on the arc from -> to that bypasses middle.
+    void unpack(uint32_t from, uint32_t to, uint32_t middle, DynamicArray<uint32_t>& path) {
+        DynamicArray<uint32_t> froms;     // Pending arcs, the next one on the path last
+        DynamicArray<HierarchyArc> arcs;
+        froms.pushBack(from);
+        arcs.pushBack(HierarchyArc(to, 0, middle));
+        while (!arcs.isEmpty()) {
+            uint32_t start = froms.popBack();
+            HierarchyArc arc = arcs.popBack();
+            if (arc.middle == NO_NODE) {
+                path.pushBack(arc.node);
+                continue;
+            }
+            // The bypassed node ranks below both ends, so both halves are stored at it.
+            HierarchyArc* first = findArc(downOffsets, downArcs, arc.middle, start);
+            HierarchyArc* second = findArc(upOffsets, upArcs, arc.middle, arc.node);
+            froms.pushBack(arc.middle);
+            arcs.pushBack(HierarchyArc(arc.node, second->weight, second->middle));
+            froms.pushBack(start);
+            arcs.pushBack(HierarchyArc(arc.middle, first->weight, first->middle));
+        }
+    }
+
+    // Settles the next node of one side of a query. Nodes that the other direction of their
+    // own side reaches more cheaply from above are stalled and not expanded.
+    void settleUpward(NodeHeap<>& pq, QueryWorkspace& own, QueryWorkspace& other,
+                      DynamicArray<uint32_t>& offsets, DynamicArray<HierarchyArc>& arcs,
+                      DynamicArray<uint32_t>& stallOffsets, DynamicArray<HierarchyArc>& stallArcs,
+                      long long& best, uint32_t& meeting, RouteStats& stats) {
+        MinHeapNode<uint32_t> current = pq.extractMin();
+        uint32_t u = current.id;
+        ++stats.settled;
+        int otherDist = other.distance(u);
+        if (otherDist != INT_MAX && (long long)current.priority + otherDist < best) {
+            best = (long long)current.priority + otherDist;
+            meeting = u;
+        }
+        for (uint32_t a = stallOffsets[u]; a < stallOffsets[u + 1]; ++a) {
+            int above = own.distance(stallArcs[a].node);
+            if (above != INT_MAX && above + stallArcs[a].weight < current.priority) {
+                return;
+            }
+        }
+        for (uint32_t a = offsets[u]; a < offsets[u + 1]; ++a) {
+            ++stats.relaxed;
+            uint32_t next = arcs[a].node;
+            int newDist = current.priority + arcs[a].weight;
+            if (newDist < own.distance(next)) {
+                own.set(next, newDist, u);
+                pq.insert(next, newDist);
+            }
+        }
+    }
+
+    // Answers a query with a forward search on up arcs from source and a backward search on
+    // down arcs from target, then unpacks the shortcuts of the best meeting.
+    RouteResult query(const RouteQuery& query) {
+        RouteResult result;
+        int n = rank.size();
+        QueryWorkspace& forward = localWorkspace(0);
+        QueryWorkspace& backward = localWorkspace(1);
+        forward.reset(n);
+        backward.reset(n);
+        forward.set(query.source, 0, NO_NODE);
+        backward.set(query.target, 0, NO_NODE);
+        forward.heap.insert(query.source, 0);
+        backward.heap.insert(query.target, 0);
+
+        long long best = LLONG_MAX;
+        uint32_t meeting = NO_NODE;
+        bool forwardTurn = true;
+        for (;;) {
+            bool forwardOpen = !forward.heap.isEmpty() && forward.heap.peekMin().priority < best
+                               && forward.heap.peekMin().priority <= query.maxCost;
+            bool backwardOpen = !backward.heap.isEmpty() && backward.heap.peekMin().priority < best
+                                && backward.heap.peekMin().priority <= query.maxCost;
+            if (!forwardOpen && !backwardOpen) break;
+            if (forwardOpen && (forwardTurn || !backwardOpen)) {
+                settleUpward(forward.heap, forward, backward, upOffsets, upArcs, downOffsets, downArcs, best, meeting, result.stats);
+            } else {
+                settleUpward(backward.heap, backward, forward, downOffsets, downArcs, upOffsets, upArcs, best, meeting, result.stats);
+            }
+            forwardTurn = !forwardTurn;
+        }
+        if (meeting == NO_NODE || best > query.maxCost) {
+            return result;
+        }
+
+        result.found = true;
+        result.cost = (int)best;
+        DynamicArray<uint32_t> up;  // meeting back down to source
+        for (uint32_t current = meeting; current != NO_NODE; current = forward.parent(current)) {
+            up.pushBack(current);
+        }
+        result.path.pushBack(query.source);
+        for (int i = up.size() - 1; i > 0; --i) {
+            HierarchyArc* arc = findArc(upOffsets, upArcs, up[i], up[i - 1]);
+            unpack(up[i], up[i - 1], arc->middle, result.path);
+        }
+        for (uint32_t current = meeting; backward.parent(current) != NO_NODE; current = backward.parent(current)) {
+            uint32_t next = backward.parent(current);
+            HierarchyArc* arc = findArc(downOffsets, downArcs, next, current);
+            unpack(current, next, arc->middle, result.path);
+        }
+        return result;
+    }
+};
+
+// One level of the overlay partition. Every cell of a level is a union of cells of the level
+// below. Boundary nodes have a road to or from another cell of the same level, and each cell
+// keeps a boundary-to-boundary distance table that customization fills in.
+class OverlayLevel {
+public:
+    int cellCount = 0;
+    DynamicArray<uint32_t> cellOf;           // Cell of every node
+    DynamicArray<uint32_t> boundaryOffsets;  // Boundary nodes of cell c start at boundaryOffsets[c]
+    DynamicArray<uint32_t> boundary;
+    DynamicArray<int> boundaryIndex;         // Position among its cell's boundary nodes, -1 for inner nodes
+    DynamicArray<uint32_t> matrixOffsets;    // Start of the k x k distance table of every cell
+    DynamicArray<int> matrix;
+    DynamicArray<uint8_t> dirty;             // Cells whose table is out of date
+    DynamicArray<uint32_t> dirtyCells;
+
+    int boundarySize(uint32_t cell) {
+        return boundaryOffsets[cell + 1] - boundaryOffsets[cell];
+    }
+
+    void markDirty(uint32_t cell) {
+        if (!dirty[cell]) {
+            dirty[cell] = 1;
+            dirtyCells.pushBack(cell);
+        }
+    }
+};
+
+// Partition based multi-level overlay in the style of Customizable Route Planning. The nested
+// partition depends only on the road layout and is built once per snapshot. Customization
+// computes the distance tables of the cells from the current weights and closures, bottom-up,
+// and after a road changes only the cells that contain it are recomputed. Queries run Dijkstra
+// that uses roads near the source and target and the coarsest tables everywhere else. Only
+// regular traffic (AVOID_BLOCKED) is modelled, since that is the metric that changes.
+class RoutingOverlay {
+public:
+    DynamicArray<OverlayLevel> levels;  // levels[0] has the smallest cells
+    DynamicArray<QueryWorkspace> workspaces;
+
+    // Partitions the snapshot and customizes every cell.
+    void build(CSRGraph& graph) {
+        const int cellSizes[] = {64, 1024};
+        const int levelCount = sizeof(cellSizes) / sizeof(cellSizes[0]);
+        levels.clear();
+        levels.resize(levelCount);
+        for (int level = levelCount - 1; level >= 0; --level) {
+            growCells(graph, cellSizes[level], level + 1 < levelCount ? &levels[level + 1].cellOf : nullptr, levels[level]);
+            findBoundary(graph, levels[level]);
+        }
+        workspaces.resize(workerCount());
+        for (int level = 0; level < levelCount; ++level) {
+            for (int cell = 0; cell < levels[level].cellCount; ++cell) {
+                levels[level].markDirty(cell);
+            }
+        }
+        customize(graph);
+    }
+
+    // Splits the nodes into cells of at most maxSize nodes by growing breadth-first regions over
+    // roads in both directions. With a parent partition, regions never leave their parent cell.
+    static void growCells(CSRGraph& graph, int maxSize, DynamicArray<uint32_t>* parent, OverlayLevel& level) {
+        int n = graph.nodeCount();
+        level.cellOf.resize(n);
+        level.cellOf.fill(NO_NODE);
+        level.cellCount = 0;
+        DynamicArray<uint32_t> queue;
+        for (int seed = 0; seed < n; ++seed) {
+            if (level.cellOf[seed] != NO_NODE) continue;
+            uint32_t cell = level.cellCount++;
+            queue.clear();
+            queue.pushBack(seed);
+            level.cellOf[seed] = cell;
+            for (int head = 0; head < queue.size() && queue.size() < maxSize; ++head) {
+                uint32_t x = queue[head];
+                for (int pass = 0; pass < 2; ++pass) {
+                    DynamicArray<uint32_t>& offsets = pass == 0 ? graph.offsets : graph.reverseOffsets;
+                    DynamicArray<uint32_t>& targets = pass == 0 ? graph.targets : graph.sources;
+                    for (uint32_t e = offsets[x]; e < offsets[x + 1] && queue.size() < maxSize; ++e) {
+                        uint32_t y = targets[e];
+                        if (level.cellOf[y] == NO_NODE && (!parent || (*parent)[y] == (*parent)[seed])) {
+                            level.cellOf[y] = cell;
+                            queue.pushBack(y);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    // Lists the boundary nodes of every cell and sizes the distance tables.
+    static void findBoundary(CSRGraph& graph, OverlayLevel& level) {
+        int n = graph.nodeCount();
+        level.boundaryIndex.resize(n);
+        level.boundaryIndex.fill(-1);
+        level.boundaryOffsets.resize(level.cellCount + 1);
+        level.boundaryOffsets.fill(0);
+        for (int x = 0; x < n; ++x) {
+            bool crossing = false;
+            for (uint32_t e = graph.offsets[x]; e < graph.offsets[x + 1] && !crossing; ++e) {
+                crossing = level.cellOf[graph.targets[e]] != level.cellOf[x];
+            }
+            for (uint32_t e = graph.reverseOffsets[x]; e < graph.reverseOffsets[x + 1] && !crossing; ++e) {
+                crossing = level.cellOf[graph.sources[e]] != level.cellOf[x];
+            }
+            if (crossing) {
+                level.boundaryIndex[x] = level.boundaryOffsets[level.cellOf[x] + 1]++;
+            }
+        }
+        for (int cell = 0; cell < level.cellCount; ++cell) {
+            level.boundaryOffsets[cell + 1] += level.boundaryOffsets[cell];
+        }
+        level.boundary.resize(level.boundaryOffsets[level.cellCount]);
+        for (int x = 0; x < n; ++x) {
+            if (level.boundaryIndex[x] >= 0) {
+                level.boundary[level.boundaryOffsets[level.cellOf[x]] + level.boundaryIndex[x]] = x;
+            }
+        }
+        level.matrixOffsets.resize(level.cellCount + 1);
+        uint32_t size = 0;
+        for (int cell = 0; cell < level.cellCount; ++cell) {
+            level.matrixOffsets[cell] = size;
+            size += level.boundarySize(cell) * level.boundarySize(cell);
+        }
+        level.matrixOffsets[level.cellCount] = size;
+        level.matrix.resize(size);
+        level.dirty.resize(level.cellCount);
+        level.dirty.fill(0);
+        level.dirtyCells.clear();
+    }
+
+    // Calls visit(next, weight) for every arc leaving x in the search graph of a level:
+    // open roads for level 0, otherwise the distance table of x's cell plus open roads that
+    // leave the cell. x must be a boundary node of its cell on levels above 0.
+    template <typename Visit>
+    void forEachArc(CSRGraph& graph, int level, uint32_t x, Visit visit) {
+        if (level == 0) {
+            for (uint32_t e = graph.offsets[x]; e < graph.offsets[x + 1]; ++e) {
+                if (!graph.isBlocked(x, e)) visit(graph.targets[e], graph.weights[e]);
+            }
+            return;
+        }
+        OverlayLevel& cells = levels[level - 1];
+        uint32_t cell = cells.cellOf[x];
+        int k = cells.boundarySize(cell);
+        int i = cells.boundaryIndex[x];
+        const int* row = &cells.matrix[cells.matrixOffsets[cell] + i * k];
+        const uint32_t* boundary = &cells.boundary[cells.boundaryOffsets[cell]];
+        for (int j = 0; j < k; ++j) {
+            if (j != i && row[j] != INT_MAX) visit(boundary[j], row[j]);
+        }
+        for (uint32_t e = graph.offsets[x]; e < graph.offsets[x + 1]; ++e) {
+            if (!graph.isBlocked(x, e) && cells.cellOf[graph.targets[e]] != cell) visit(graph.targets[e], graph.weights[e]);
+        }
+    }
+
+    // Dijkstra from source over the arcs of arcLevel that stay inside one cell of cellLevel.
+    // Stops early once stopAt is settled.
+    void cellSearch(CSRGraph& graph, int arcLevel, int cellLevel, uint32_t source, uint32_t stopAt, QueryWorkspace& workspace) {
+        DynamicArray<uint32_t>& cellOf = levels[cellLevel - 1].cellOf;
+        uint32_t cell = cellOf[source];
+        NodeHeap<>& pq = workspace.heap;
+        workspace.reset(graph.nodeCount());
+        workspace.set(source, 0, NO_NODE);
+        pq.insert(source, 0);
+        while (!pq.isEmpty()) {
+            MinHeapNode<uint32_t> current = pq.extractMin();
+            if (current.id == stopAt) break;
+            forEachArc(graph, arcLevel, current.id, [&](uint32_t next, int weight) {
+                int newDist = current.priority + weight;
+                if (cellOf[next] == cell && newDist < workspace.distance(next)) {
+                    workspace.set(next, newDist, current.id);
+                    pq.insert(next, newDist);
+                }
+            });
+        }
+    }
+
+    // Recomputes the distance table of one cell from the level below.
+    void customizeCell(CSRGraph& graph, int level, uint32_t cell, QueryWorkspace& workspace) {
+        OverlayLevel& cells = levels[level - 1];
+        int k = cells.boundarySize(cell);
+        uint32_t first = cells.boundaryOffsets[cell];
+        uint32_t table = cells.matrixOffsets[cell];
+        for (int i = 0; i < k; ++i) {
+            cellSearch(graph, level - 1, level, cells.boundary[first + i], NO_NODE, workspace);
+            for (int j = 0; j < k; ++j) {
+                cells.matrix[table + i * k + j] = workspace.distance(cells.boundary[first + j]);
+            }
+        }
+    }
+
+    // Records that a road changed. The lowest cell containing both ends has to be recomputed;
+    // cells above follow during customization only if that cell's table actually changes.
+    void roadChanged(uint32_t from, uint32_t to) {
+        for (int level = 0; level < levels.size(); ++level) {
+            if (levels[level].cellOf[from] == levels[level].cellOf[to]) {
+                levels[level].markDirty(levels[level].cellOf[from]);
+                return;
+            }
+        }
+    }
+
+    bool needsCustomization() {
+        for (int level = 0; level < levels.size(); ++level) {
+            if (!levels[level].dirtyCells.isEmpty()) return true;
+        }
+        return false;
+    }
+
+    // Recomputes the dirty cells level by level, in parallel within a level.
+    void customize(CSRGraph& graph) {
+        DynamicArray<uint8_t> changed;
+        for (int level = 0; level < levels.size(); ++level) {
+            OverlayLevel& cells = levels[level];
+            changed.resize(cells.dirtyCells.size());
+            parallelFor(cells.dirtyCells.size(), [&](int i, int worker) {
+                uint32_t cell = cells.dirtyCells[i];
+                uint32_t table = cells.matrixOffsets[cell];
+                DynamicArray<int> before(cells.matrixOffsets[cell + 1] - table);
+                for (int j = 0; j < before.size(); ++j) before[j] = cells.matrix[table + j];
+                customizeCell(graph, level + 1, cell, workspaces[worker]);
+                changed[i] = 0;
+                for (int j = 0; j < before.size() && !changed[i]; ++j) changed[i] = before[j] != cells.matrix[table + j];
+            });
+            for (int i = 0; i < cells.dirtyCells.size(); ++i) {
+                uint32_t cell = cells.dirtyCells[i];
+                cells.dirty[cell] = 0;
+                if (changed[i] && level + 1 < levels.size()) {
+                    // Any node of the cell names its parent cell.
+                    uint32_t member = cells.boundary[cells.boundaryOffsets[cell]];
+                    levels[level + 1].markDirty(levels[level + 1].cellOf[member]);
+                }
+            }
+            cells.dirtyCells.clear();
+        }
+    }
+
+    // Level whose arcs a query from source to target uses at x: the highest level where x
+    // shares a cell with neither end, 0 (plain roads) near the ends.
+    int queryLevel(uint32_t x, uint32_t source, uint32_t target) {
+        for (int level = levels.size(); level > 0; --level) {
+            DynamicArray<uint32_t>& cellOf = levels[level - 1].cellOf;
+            if (cellOf[x] != cellOf[source] && cellOf[x] != cellOf[target]) return level;
+        }
+        return 0;
+    }
+
+    // Appends the roads of an arc of the level search graph, after from. A table arc is
+    // searched again inside its cell one level down, and the arcs found there are unpacked
+    // in turn, so each step only looks at one cell of the next finer level.
+    void unpack(CSRGraph& graph, int level, uint32_t from, uint32_t to, int cost, DynamicArray<uint32_t>& path) {
+        int slot = graph.findSlot(from, to);
+        if (level == 0 || (slot >= 0 && !graph.isBlocked(from, slot) && graph.weights[slot] == cost)) {
+            path.pushBack(to);
+            return;
+        }
+        // The workspace is free for the finer levels again once the hops are copied out.
+        QueryWorkspace& workspace = localWorkspace(1);
+        cellSearch(graph, level - 1, level, from, to, workspace);
+        DynamicArray<uint32_t> hops;  // Path inside the cell from to back to from
+        DynamicArray<int> costs;
+        for (uint32_t current = to; current != NO_NODE; current = workspace.parent(current)) {
+            hops.pushBack(current);
+            costs.pushBack(workspace.distance(current));
+        }
+        for (int i = hops.size() - 1; i > 0; --i) {
+            unpack(graph, level - 1, hops[i], hops[i - 1], costs[i - 1] - costs[i], path);
+        }
+    }
+
+    // Answers a query, then expands every table arc of the result into roads.
+    RouteResult query(CSRGraph& graph, const RouteQuery& query) {
+        RouteResult result;
+        QueryWorkspace& workspace = localWorkspace(0);
+        NodeHeap<>& pq = workspace.heap;
+        workspace.reset(graph.nodeCount());
+        workspace.set(query.source, 0, NO_NODE);
+        pq.insert(query.source, 0);
+        while (!pq.isEmpty()) {
+            MinHeapNode<uint32_t> current = pq.extractMin();
+            if (current.priority > query.maxCost) break;
+            ++result.stats.settled;
+            if (current.id == query.target) break;
+            int level = queryLevel(current.id, query.source, query.target);
+            forEachArc(graph, level, current.id, [&](uint32_t next, int weight) {
+                ++result.stats.relaxed;
+                int newDist = current.priority + weight;
+                if (newDist < workspace.distance(next)) {
+                    workspace.set(next, newDist, current.id);
+                    pq.insert(next, newDist);
+                }
+            });
+        }
+        int cost = workspace.distance(query.target);
+        if (cost == INT_MAX || cost > query.maxCost) {
+            return result;
+        }
+
+        result.found = true;
+        result.cost = cost;
+        DynamicArray<uint32_t> hops;  // Overlay path from target back to source
+        for (uint32_t current = query.target; current != NO_NODE; current = workspace.parent(current)) {
+            hops.pushBack(current);
+        }
+        result.path.pushBack(query.source);
+        for (int i = hops.size() - 1; i > 0; --i) {
+            int level = queryLevel(hops[i], query.source, query.target);
+            unpack(graph, level, hops[i], hops[i - 1], workspace.distance(hops[i - 1]) - workspace.distance(hops[i]), result.path);
+        }
+        return result;
+    }
+};
+
+// Read-only memory mapping of a whole file. Loaders scan the mapped bytes in place instead
+// of copying every line through a stream.
+class MappedFile {
+public:
+    const char* data;
+    size_t size;
+#ifdef _WIN32
+    HANDLE file;
+    HANDLE mapping;
+#endif
+
+    MappedFile() : data(nullptr), size(0) {
+#ifdef _WIN32
+        file = INVALID_HANDLE_VALUE;
+        mapping = nullptr;
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile() {
+        close();
+    }
+
+    // Maps filename and returns false if it can't be opened. An empty file maps to no bytes.
+    bool open(const string& filename) {
+        close();
+#ifdef _WIN32
+        file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                           FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        LARGE_INTEGER fileSize;
+        if (file == INVALID_HANDLE_VALUE || !GetFileSizeEx(file, &fileSize)) {
+            close();
+            return false;
+        }
+        size = (size_t)fileSize.QuadPart;
+        if (size == 0) {
+            data = "";
+            return true;
+        }
+        mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        data = mapping ? (const char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+#else
+        int descriptor = ::open(filename.c_str(), O_RDONLY);
+        struct stat info;
+        if (descriptor < 0 || fstat(descriptor, &info) != 0) {
+            if (descriptor >= 0) ::close(descriptor);
+            return false;
+        }
+        size = (size_t)info.st_size;
+        if (size == 0) {
+            ::close(descriptor);
+            data = "";
+            return true;
+        }
+        void* bytes = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+        ::close(descriptor);  // The mapping keeps the file alive.
+        if (bytes != MAP_FAILED) {
+            madvise(bytes, size, MADV_SEQUENTIAL);
+            data = (const char*)bytes;
+        }
+#endif
+        if (!data) {
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    void close() {
+#ifdef _WIN32
+        if (data && size > 0) UnmapViewOfFile(data);
+        if (mapping) CloseHandle(mapping);
+        if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+        mapping = nullptr;
+        file = INVALID_HANDLE_VALUE;
+#else
+        if (data && size > 0) munmap((void*)data, size);
+#endif
+        data = nullptr;
+        size = 0;
+    }
+};
+
+// Splits a mapped CSV file into rows of comma separated fields without copying them; the
+// fields point into the mapping. The header row is skipped. Like getline on each field, an
+// empty line has no fields and a trailing comma doesn't add an empty one.
+class CsvReader {
+public:
+    MappedFile file;
+    const char* cursor = nullptr;
+    const char* end = nullptr;
+    DynamicArray<StringView> fields;  // Fields of the current row
+
+    bool open(const string& filename) {
+        if (!file.open(filename)) {
+            return false;
+        }
+        cursor = file.data;
+        end = file.data + file.size;
+        nextRow();
+        return true;
+    }
+
+    // Moves to the next row and splits it into fields. Returns false at the end of the file.
+    bool nextRow() {
+        if (cursor >= end) {
+            return false;
+        }
+        const char* lineEnd = (const char*)memchr(cursor, '\n', end - cursor);
+        const char* next = lineEnd ? lineEnd + 1 : end;
+        if (!lineEnd) lineEnd = end;
+        if (lineEnd > cursor && lineEnd[-1] == '\r') --lineEnd;
+        fields.clear();
+        const char* start = cursor;
+        while (start < lineEnd) {
+            const char* comma = (const char*)memchr(start, ',', lineEnd - start);
+            const char* fieldEnd = comma ? comma : lineEnd;
+            fields.pushBack(StringView(start, fieldEnd - start));
+            if (!comma) break;
+            start = comma + 1;
+        }
+        cursor = next;
+        return true;
+    }
+};
+
+class Graph {
+public:
+    int timer = 0;
+    HashTable<uint32_t> nodeIds;   // Interns intersection names into dense indices.
+    DynamicArray<GraphNode> nodes; // Intersections, indexed by their dense index.
+    CSRGraph csr;                  // Snapshot of the adjacency lists that all traversals read.
+    bool csrStale = true;          // Set when roads or intersections are added after the last build.
+    LandmarkIndex landmarks;       // ALT tables, built on the first ALT query after each snapshot rebuild.
+    bool landmarksStale = true;
+    int landmarkCount = 8;
+    int alternativeCount = 5;      // Routes menu option 7 lists
+    int auditPathLimit = 100;      // Routes menu option 16 lists at most
+    ContractionHierarchy contraction;  // Hierarchy of all roads, for emergency routing
+    bool hierarchyStale = true;
+    int hierarchyBuilds = 0;
+    RoutingOverlay overlay;        // Partitioned once per snapshot, customized after road changes.
+    ReachabilityIndex reachability[2];          // One per BlockedPolicy
+    bool reachabilityStale[2] = {true, true};
+    DominatorTree dominators;      // Dominators of the open roads from the last closure impact query
+    bool dominatorsStale = true;
+    bool overlayStale = true;
+    DynamicArray<DynamicShortestPaths> sourceTrees;  // Trees of watched sources, repaired after road changes.
+    bool sourceTreesStale = true;
+    TimingWheel signalWheel;       // Next signal change of every intersection in the snapshot
+    DynamicArray<uint32_t> signalChanges;
+    LinkedList<Vehicles> vehicles;
+    MinHeap<Vehicles> emergencyVehicles;
+    DynamicArray<Vehicles> emergencyArrivals;  // Emergency vehicles in the order they were loaded
+
+    // Returns the dense index of an intersection, or NO_NODE if it doesn't exist.
+    uint32_t indexOf(StringView id) {
+        uint32_t* index = nodeIds.search(id);
+        return index ? *index : NO_NODE;
+    }
+
+    // Returns the CSR snapshot, rebuilding it first if the network changed since the last build.
+    CSRGraph& snapshot() {
+        if (csrStale) {
+            csr.build(nodes);
+            csr.signalTime = timer;
+            signalWheel.reset(timer);
+            for (int i = 0; i < csr.nodeCount(); ++i) {
+                if (csr.greenTimes[i] > 0) {
+                    signalWheel.schedule(i, csr.nextSignalChange(i, timer));
+                }
+            }
+            csrStale = false;
+            landmarksStale = true;
+            hierarchyStale = true;
+            dominatorsStale = true;
+            overlayStale = true;
+            sourceTreesStale = true;
+        } else if (csr.signalTime != timer) {
+            syncSignals();
+        }
+        return csr;
+    }
+
+    // Moves the snapshot's signals to the current time. Searches read signals on the fly, but
+    // the overlay and the watched trees hold results for one signal state, so every
+    // intersection whose signal changed is passed on to them. The timing wheel hands out
+    // just the intersections with a change due since the last call.
+    void syncSignals() {
+        int previous = csr.signalTime;
+        csr.signalTime = timer;
+        signalChanges.clear();
+        signalWheel.advance(timer, signalChanges);
+        for (int c = 0; c < signalChanges.size(); ++c) {
+            uint32_t i = signalChanges[c];
+            signalWheel.schedule(i, csr.nextSignalChange(i, timer));
+            if (csr.isRed(i, previous) == csr.isRed(i, timer)) continue;  // Changed and back again
+            if (!overlayStale) {
+                for (uint32_t e = csr.offsets[i]; e < csr.offsets[i + 1]; ++e) {
+                    overlay.roadChanged(i, csr.targets[e]);
+                }
+            }
+            if (!sourceTreesStale) {
+                for (int t = 0; t < sourceTrees.size(); ++t) {
+                    sourceTrees[t].signalChanged(csr, i);
+                }
+            }
+        }
+    }
+
+    // Starts keeping the shortest path tree of a source up to date and returns its handle
+    // for sourceTree. Watching the same source and policy again returns the same handle.
+    int watchSource(uint32_t source, BlockedPolicy blockedPolicy = AVOID_BLOCKED) {
+        for (int i = 0; i < sourceTrees.size(); ++i) {
+            if (sourceTrees[i].tree.source == source && sourceTrees[i].ignoreBlocked == (blockedPolicy == IGNORE_BLOCKED)) {
+                return i;
+            }
+        }
+        sourceTrees.pushBack(DynamicShortestPaths(source, blockedPolicy == IGNORE_BLOCKED));
+        if (!sourceTreesStale) {
+            sourceTrees[sourceTrees.size() - 1].build(snapshot());
+        }
+        return sourceTrees.size() - 1;
+    }
+
+    // Returns the current tree of a watched source. Trees are rebuilt after a snapshot
+    // rebuild and repaired in place after blocks and weight changes.
+    ShortestPathTree& sourceTree(int handle) {
+        CSRGraph& graph = snapshot();
+        if (sourceTreesStale) {
+            for (int i = 0; i < sourceTrees.size(); ++i) {
+                sourceTrees[i].build(graph);
+            }
+            sourceTreesStale = false;
+        }
+        return sourceTrees[handle].tree;
+    }
+
+    // Repairs every watched tree after the road in a snapshot slot changed.
+    void repairSourceTrees(uint32_t from, uint32_t slot) {
+        if (sourceTreesStale) return;
+        for (int i = 0; i < sourceTrees.size(); ++i) {
+            sourceTrees[i].roadChanged(csr, from, slot);
+        }
+    }
+
+    // Returns the routing overlay, partitioning it after a snapshot rebuild and recomputing
+    // the cells touched by road changes since the last call.
+    RoutingOverlay& routingOverlay() {
+        CSRGraph& graph = snapshot();
+        if (overlayStale) {
+            overlay.build(graph);
+            overlayStale = false;
+        } else if (overlay.needsCustomization()) {
+            overlay.customize(graph);
+        }
+        return overlay;
+    }
+
+    // Returns the contraction hierarchy of all roads, rebuilding it if the roads or their
+    // weights changed. hierarchyBuilds counts the builds so callers can report them. It leaves
+    // closures and signals out, so only queries that ignore blocks can use it; the fleet
+    // listings and addVehicle route regular traffic over the overlay instead.
+    ContractionHierarchy& hierarchy() {
+        CSRGraph& graph = snapshot();
+        if (hierarchyStale) {
+            contraction.build(graph);
+            hierarchyStale = false;
+            ++hierarchyBuilds;
+        }
+        return contraction;
+    }
+
+    // Returns the landmark tables of the current snapshot, rebuilding them if the roads changed.
+    LandmarkIndex& landmarkIndex() {
+        CSRGraph& graph = snapshot();
+        if (landmarksStale) {
+            landmarks.build(graph, landmarkCount);
+            landmarksStale = false;
+        }
+        return landmarks;
+    }
+
+    // Returns the reachability index for a blocked-road policy, rebuilding it if the roads
+    // changed in a way its labels can't absorb.
+    ReachabilityIndex& reachabilityIndex(BlockedPolicy policy) {
+        CSRGraph& graph = snapshot();
+        if (reachabilityStale[policy]) {
+            reachability[policy].build(graph, policy == IGNORE_BLOCKED);
+            reachabilityStale[policy] = false;
+        }
+        return reachability[policy];
+    }
+
+    // False only if target can't be reached from source; see ReachabilityIndex.
+    bool mayReach(uint32_t source, uint32_t target, BlockedPolicy blockedPolicy = AVOID_BLOCKED) {
+        return reachabilityIndex(blockedPolicy).mayReach(source, target);
+    }
+
+    // Returns the dominator tree of the open roads from root, rebuilding it if the root or
+    // the roads changed, or a road the root reaches was closed or reopened.
+    DominatorTree& dominatorTree(uint32_t root) {
+        CSRGraph& graph = snapshot();
+        if (dominatorsStale || dominators.root != root) {
+            dominators.build(graph, root);
+            dominatorsStale = false;
+        }
+        return dominators;
+    }
+
+    // Number of intersections from can no longer reach once the road from -> to is closed;
+    // see DominatorTree. Only the tree of the last from is kept: asking about roads that
+    // leave the same intersection is cheap, and a new from costs one rebuild.
+    uint32_t closureImpact(uint32_t from, uint32_t to) {
+        DominatorTree& tree = dominatorTree(from);
+        int slot = csr.findSlot(from, to);
+        return slot < 0 ? 0 : tree.cutOffByRoad(csr, slot);
+    }
+
+    // Closes or reopens a road and mirrors it into the snapshot. Signals don't touch this state.
+    void setBlocked(uint32_t from, Edge& edge, bool blocked) {
+        if (edge.blocked == blocked) return;
+        edge.blocked = blocked;
+        if (!reachabilityStale[AVOID_BLOCKED]) {
+            ReachabilityIndex& index = reachability[AVOID_BLOCKED];
+            reachabilityStale[AVOID_BLOCKED] = blocked ? !index.survivesClosing(from, edge.destination)
+                                                       : !index.survivesOpening(from, edge.destination);
+        }
+        // Routes from the tree's root never use a road whose start the root doesn't reach.
+        if (!dominatorsStale && dominators.reaches(from)) {
+            dominatorsStale = true;
+        }
+        if (!csrStale) {
+            int slot = csr.findSlot(from, edge.destination);
+            if (slot >= 0) {
+                csr.setBlocked(slot, blocked);
+                repairSourceTrees(from, slot);
+            }
+            if (!overlayStale) {
+                overlay.roadChanged(from, edge.destination);
+            }
+        }
+    }
+
+    // Sets the weight of a road and mirrors it into the snapshot. The hierarchy and the
+    // landmarks assume the old weights and are rebuilt; the overlay only recomputes its cells.
+    void setWeight(uint32_t from, Edge& edge, int weight) {
+        if (edge.weight == weight) return;
+        edge.weight = weight;
+        landmarksStale = true;
+        hierarchyStale = true;
+        if (!csrStale) {
+            int slot = csr.findSlot(from, edge.destination);
+            if (slot >= 0) {
+                csr.setWeight(slot, weight);
+                repairSourceTrees(from, slot);
+            }
+            if (!overlayStale) {
+                overlay.roadChanged(from, edge.destination);
+            }
+        }
+    }
+
+    // Returns the name of an intersection for display.
+    const string& nameOf(uint32_t index) {
+        return nodes[index].id;
+    }
+
+    // Find a node by id, or nullptr if it doesn't exist.
+    GraphNode* findNode(string& id) {
+        uint32_t index = indexOf(id);
+        return index == NO_NODE ? nullptr : &nodes[index];
+    }
+
+    // Add a node to the graph and return its index.
+    uint32_t addNode(string& id) {
+        uint32_t index = indexOf(id);
+        if (index != NO_NODE) {
+            return index;  // Node already exists
+        }
+        index = nodes.size();
+        nodeIds.insert(id, index);
+        nodes.pushBack(GraphNode(id));
+        csrStale = true;
+        // The reachability labels and the dominator tree have one entry per node.
+        reachabilityStale[AVOID_BLOCKED] = reachabilityStale[IGNORE_BLOCKED] = true;
+        dominatorsStale = true;
+        return index;
+    }
+
+    // Adds a node named by a view and returns its index, copying the name only if it is new.
+    uint32_t addNode(StringView id) {
+        uint32_t index = indexOf(id);
+        if (index != NO_NODE) {
+            return index;
+        }
+        string name = id.str();
+        return addNode(name);
+    }
+
+    // Get the edge between two nodes
+    Edge* getEdge(uint32_t from, uint32_t to) {
+        return nodes[from].getEdge(to);
+    }
+
+    // Get the edge between two nodes by name.
+    Edge* getEdge(string& from, string& to) {
+        uint32_t fromIndex = indexOf(from);
+        uint32_t toIndex = indexOf(to);
+        if (fromIndex == NO_NODE || toIndex == NO_NODE) {
+            cout << "Invalid nodes.\n";
+            return nullptr;
+        }
+        return getEdge(fromIndex, toIndex);
+    }
+
+    // Block an edge between two nodes
+    void blockEdge(string from, string to) {
+        uint32_t fromIndex = indexOf(from);
+        if (fromIndex == NO_NODE) {
+            cout << "Node '" << from << "' doesn't exist.\n";
+            return;
+        }
+        uint32_t toIndex = indexOf(to);
+        Edge* edge = toIndex == NO_NODE ? nullptr : getEdge(fromIndex, toIndex);
+        if (edge) {
+            setBlocked(fromIndex, *edge, true);
+            cout << "Road blocked from " << from << " to " << to << endl;
+        } else {
+            cout << "Road doesn't exist.\n";
+        }
+    }
+
+    // Add an edge between two nodes
+    void addEdge(uint32_t from, uint32_t to, int weight, int vehicles = 0) {
+        if (nodes[from].addNeighbor(to, weight, vehicles)) {
+            nodes[to].incoming.enqueue(from);
+            roadAdded(from, to);
+        }
+        csrStale = true;
+    }
+
+    // Keeps the reachability index of each policy through a new open road from -> to if its
+    // labels already let from reach to. The road then merges no components and opens no pair
+    // the labels rule out; otherwise the index is rebuilt on its next use.
+    void roadAdded(uint32_t from, uint32_t to) {
+        for (int policy = AVOID_BLOCKED; policy <= IGNORE_BLOCKED; ++policy) {
+            if (!reachabilityStale[policy]) {
+                reachabilityStale[policy] = !reachability[policy].survivesOpening(from, to);
+            }
+        }
+    }
+
+    // Adds many roads with the same result as calling addEdge for each in order: a repeated
+    // road keeps its first weight. Duplicates are found by grouping the roads by start and
+    // stamping targets, instead of scanning a neighbor list for every road.
+    void addRoads(DynamicArray<uint32_t>& from, DynamicArray<uint32_t>& to, DynamicArray<int>& weights) {
+        int n = nodes.size();
+        int m = from.size();
+        DynamicArray<uint32_t> starts(n + 1, 0);
+        for (int i = 0; i < m; ++i) {
+            ++starts[from[i] + 1];
+        }
+        for (int u = 0; u < n; ++u) {
+            starts[u + 1] += starts[u];
+        }
+        DynamicArray<uint32_t> byStart(m);
+        DynamicArray<uint32_t> next(starts);
+        for (int i = 0; i < m; ++i) {
+            byStart[next[from[i]]++] = i;
+        }
+        DynamicArray<uint32_t> stamps(n, NO_NODE);
+        DynamicArray<bool> keep(m, false);
+        for (int u = 0; u < n; ++u) {
+            if (starts[u] == starts[u + 1]) continue;
+            for (Node<Edge>* current = nodes[u].neighbors.head; current; current = current->next) {
+                stamps[current->data.destination] = u;
+            }
+            for (uint32_t k = starts[u]; k < starts[u + 1]; ++k) {
+                int i = byStart[k];
+                if (stamps[to[i]] == (uint32_t)u) continue;
+                stamps[to[i]] = u;
+                keep[i] = true;
+            }
+        }
+        for (int i = 0; i < m; ++i) {
+            if (!keep[i]) continue;
+            nodes[from[i]].neighbors.enqueue(Edge(to[i], weights[i], 0));
+            nodes[to[i]].incoming.enqueue(from[i]);
+            roadAdded(from[i], to[i]);
+        }
+        csrStale = true;
+    }
+
+    // Add an edge between two nodes by name.
+    void addEdge(string& from, string& to, int weight, int vehicles = 0) {
+        uint32_t fromIndex = indexOf(from);
+        uint32_t toIndex = indexOf(to);
+
+        if (fromIndex == NO_NODE || toIndex == NO_NODE) {
+            cout << "Either one of the nodes is missing!\n";
+            return;
+        }
+
+        addEdge(fromIndex, toIndex, weight, vehicles);
+    }
+
+    // Displays all neighbors of an intersection.
+    void printNeighbors(GraphNode& node) {
+        Node<Edge>* current = node.neighbors.head;
+        while (current) {
+            cout << "(" << nameOf(current->data.destination) << ", "
+                 << current->data.weight  << ")";
+            if (current->next) cout << " -> ";
+            current = current->next;
+        }
+        cout << endl;
+    }
+
+    // Displays a path of intersection indices by name.
+    void printPath(DynamicArray<uint32_t>& path) {
+        for (int i = 0; i < path.size(); ++i) {
+            cout << nameOf(path[i]);
+            if (i != path.size() - 1)
+                cout << " -> ";
+        }
+    }
+
+    // Print the entire graph
+    void printGraph() {
+        cout << "------ City Traffic Network ------" << endl;
+        for (int i = 0; i < nodes.size(); ++i) {
+            cout << nodes[i].id << " -> ";
+            printNeighbors(nodes[i]);
+        }
+    }
+
+    // Display all the vehicles and their destinations.
+    void showVehicles() {
+        Node<Vehicles>* head = vehicles.head;
+        while (head) {
+            cout << head->data.id << " moving from " << nameOf(head->data.start) << " to " << nameOf(head->data.end) << endl;
+            head = head->next;
+        }
+    }
+
+    // Display all the emergency vehicles and their destinations.
+    void showEmergencyVehicles() {
+        for (int i = 0; i < emergencyArrivals.size(); ++i) {
+            Vehicles& vehicle = emergencyArrivals[i];
+            cout << vehicle.id << " moving from " << nameOf(vehicle.start) << " to " << nameOf(vehicle.end) << " with priority " << emergencyVehicles.priorityOf(vehicle) << endl;
+        }
+    }
+
+    // Show blocked roads
+    void showBlocked() {
+        cout << "------ Blocked Roads ------" << endl;
+        for (int i = 0; i < nodes.size(); ++i) {
+            GraphNode& node = nodes[i];
+            Node<Edge>* current = node.neighbors.head;
+            while (current) {
+                if (current->data.blocked) {
+                    cout << node.id << " to " << nameOf(current->data.destination) << " is blocked.\n";
+                }
+                current = current->next;
+            }
+        }
     }
 
     // Show traffic signals.
     void showTraffic() {
         cout << "------ Traffic Signal Status ------" << endl;
-        for (int i = 0; i < sizeX; ++i) {
-            if (vertices.arr[i].occupied) {
-                GraphNode& node = vertices.arr[i].data;
-                cout << "Intersection " << node.id << " Green Time: " << node.greenTime << "s" << endl;
+        for (int i = 0; i < nodes.size(); ++i) {
+            GraphNode& node = nodes[i];
+            cout << "Intersection " << node.id << " Green Time: " << node.greenTime << "s"
+                 << (node.isRed(timer) ? " (Red)" : " (Green)") << endl;
+        }
+    }
+    // Runs a breadth first search from source; levels and parents of the result hold
+    // the hop count and predecessor of every reachable intersection.
+    BreadthFirstSearch breadthFirst(uint32_t source, BlockedPolicy blockedPolicy = AVOID_BLOCKED) {
+        BreadthFirstSearch search(snapshot(), blockedPolicy);
+        search.run(source);
+        return search;
+    }
+
+    // Lists the intersections reachable from source in depth first preorder, visiting
+    // roads in adjacency order.
+    DynamicArray<uint32_t> depthFirstOrder(uint32_t source, BlockedPolicy blockedPolicy = AVOID_BLOCKED) {
+        CSRGraph& graph = snapshot();
+        bool ignoreBlocked = blockedPolicy == IGNORE_BLOCKED;
+        DynamicArray<uint32_t> order;
+        DynamicArray<uint32_t> stack;      // Nodes on the current branch
+        DynamicArray<uint32_t> nextSlots;  // Next road to try from each node on the branch
+        DenseBitset visited;
+        visited.reset(graph.nodeCount());
+        visited.set(source);
+        order.pushBack(source);
+        stack.pushBack(source);
+        nextSlots.pushBack(graph.offsets[source]);
+        while (!stack.isEmpty()) {
+            uint32_t u = stack.back();
+            uint32_t& e = nextSlots.back();
+            if (e == graph.offsets[u + 1]) {
+                stack.popBack();
+                nextSlots.popBack();
+                continue;
             }
+            uint32_t slot = e++;
+            uint32_t v = graph.targets[slot];
+            if (visited.test(v) || (!ignoreBlocked && graph.isBlocked(u, slot))) continue;
+            visited.set(v);
+            order.pushBack(v);
+            stack.pushBack(v);
+            nextSlots.pushBack(graph.offsets[v]);
         }
+        return order;
     }
+
     // Breath first search
     void bfs(string startId) {
-        GraphNode* start = findNode(startId);
-        if (!start) {
+        uint32_t start = indexOf(startId);
+        if (start == NO_NODE) {
+            cout << "Start node not found!" << endl;
+            return;
+        }
+
+        BreadthFirstSearch search = breadthFirst(start, IGNORE_BLOCKED);
+        CSRGraph& graph = search.graph;
+        // Prints each level in the order a queue would have discovered it.
+        DynamicArray<uint32_t> order;
+        DenseBitset listed;
+        listed.reset(nodes.size());
+        order.pushBack(start);
+        listed.set(start);
+        for (int i = 0; i < order.size(); ++i) {
+            uint32_t from = order[i];
+            cout << nameOf(from) << " ";
+            for (uint32_t e = graph.offsets[from]; e < graph.offsets[from + 1]; ++e) {
+                uint32_t to = graph.targets[e];
+                if (!listed.test(to) && search.levels[to] == search.levels[from] + 1) {
+                    listed.set(to);
+                    order.pushBack(to);
+                }
+            }
+        }
+        cout << endl;
+    }
+
+    // Depth first search function
+    void dfs(string startId) {
+        uint32_t start = indexOf(startId);
+        if (start == NO_NODE) {
             cout << "Start node not found!" << endl;
             return;
         }
+        DynamicArray<uint32_t> order = depthFirstOrder(start, IGNORE_BLOCKED);
+        for (int i = 0; i < order.size(); ++i) {
+            cout << nameOf(order[i]) << " ";
+        }
+        cout << endl;
+    }
+
+    // Load blocked roads from a file
+    void loadBlocked(string filename) {
+        CsvReader csv;
+        if (!csv.open(filename)) {
+            cout << "File doesn't exist.\n";
+            return;
+        }
+        while (csv.nextRow()) {
+            DynamicArray<StringView>& fields = csv.fields;
+            if (fields.size() >= 3 && fields[2] == "Blocked") {
+                blockEdge(fields[0].str(), fields[1].str());
+            }
+        }
+    }
+
+    // Read road network inputs from csv. Names are looked up in place and only copied for new
+    // intersections; the roads are collected and added in one addRoads call.
+    void loadNetwork(string filename) {
+        CsvReader csv;
+        if (!csv.open(filename)) {
+            cout << "File doesn't exist.\n";
+            return;
+        }
+        DynamicArray<uint32_t> from;
+        DynamicArray<uint32_t> to;
+        DynamicArray<int> weights;
+        while (csv.nextRow()) {
+            DynamicArray<StringView>& fields = csv.fields;
+            int weight;
+            if (fields.size() >= 3 && parseInt(fields[2], weight)) {
+                from.pushBack(addNode(fields[0]));
+                to.pushBack(addNode(fields[1]));
+                weights.pushBack(weight);
+            }
+        }
+        addRoads(from, to, weights);
+    }
+
+    // Read vehicles data from csv.
+    void loadVehicles(string filename) {
+        CsvReader csv;
+        if (!csv.open(filename)) {
+            cout << "File doesn't exist.\n";
+            return;
+        }
+        while (csv.nextRow()) {
+            DynamicArray<StringView>& fields = csv.fields;
+            if (fields.size() >= 3) {
+                addVehicle(fields[0].str(), fields[1].str(), fields[2].str());
+            }
+        }
+    }
+
+    // Read emergency vehicles data from csv.
+    void loadEmergencyVehicles(string filename) {
+        CsvReader csv;
+        if (!csv.open(filename)) {
+            cout << "File doesn't exist.\n";
+            return;
+        }
+        while (csv.nextRow()) {
+            DynamicArray<StringView>& fields = csv.fields;
+            if (fields.size() < 4) continue;
+            string id = fields[0].str();
+            uint32_t start = indexOf(fields[1]);
+            uint32_t end = indexOf(fields[2]);
+            if (start == NO_NODE || end == NO_NODE) {
+                cout << "Unknown intersection for emergency vehicle " << id << endl;
+                continue;
+            }
+            StringView priority = fields[3];
+            int priorityInt = (priority == "High")? 0 : (priority == "Medium")? 1 : (priority == "Low")? 2 : -1;
+            cout << "Inserting Emergency Vehicle: "
+ << id << " with priority " << priorityInt << endl;
+            Vehicles vehicle(id, start, end);
+            if (!emergencyVehicles.contains(vehicle)) {
+                emergencyArrivals.pushBack(vehicle);
+            }
+            emergencyVehicles.insert(vehicle, priorityInt);
+        }
+    }
+
+    // Read signals data from csv.
+    void loadSignals(string filename) {
+        CsvReader csv;
+        if (!csv.open(filename)) {
+            cout << "File doesn't exist.\n";
+            return;
+        }
+        while (csv.nextRow()) {
+            DynamicArray<StringView>& fields = csv.fields;
+            int greenTime, phaseOffset;
+            if (fields.size() < 2) continue;
+            uint32_t index = indexOf(fields[0]);
+            if (index == NO_NODE || !parseInt(fields[1], greenTime)) continue;
+            GraphNode& node = nodes[index];
+            node.greenTime = greenTime;
+            if (fields.size() >= 3 && node.greenTime > 0 && parseInt(fields[2], phaseOffset)) {
+                int cycle = 2 * node.greenTime;  // Keeps the offset non-negative
+                node.phaseOffset = (phaseOffset % cycle + cycle) % cycle;
+            }
+            csrStale = true;
+        }
+    }
+
+    // Loads all csv files.
+    void load() {
+        loadNetwork("road_network.csv");
+        loadBlocked("road_closures.csv");
+        snapshot();  // Freeze the network before vehicles are routed on it.
+        loadVehicles("vehicles.csv");
+        loadEmergencyVehicles("emergency_vehicles.csv");
+        loadSignals("traffic_signals.csv");
+    }
+
+    // Decides whether a search on this snapshot runs on the bucket queue. It needs every weight
+    // to be a small non-negative integer, so BUCKET_QUEUE falls back to the heap otherwise.
+    bool useBucketQueue(CSRGraph& graph, QueueBackend backend) {
+        bool bounded = graph.minWeight >= 0 && graph.maxWeight <= bucketQueueMaxWeight;
+        return backend != HEAP_QUEUE && bounded;
+    }
+
+    // Dijkstra's main loop on any queue with the NodeHeap interface. Stops once the target
+    // is settled or the next node would cost more than query.maxCost.
+    template <typename Queue>
+    void dijkstraSearch(CSRGraph& graph, Queue& pq, const RouteQuery& query, QueryWorkspace& workspace, RouteStats& stats) {
+        bool ignoreBlocked = query.blockedPolicy == IGNORE_BLOCKED;
+        workspace.set(query.source, 0, NO_NODE);
+        pq.insert(query.source, 0);
+
+        while (!pq.isEmpty()) {
+            MinHeapNode<uint32_t> current = pq.extractMin();
+            if (current.priority > query.maxCost) break;
+            ++stats.settled;
+            if (current.id == query.target) break;
+
+            for (uint32_t e = graph.offsets[current.id]; e < graph.offsets[current.id + 1]; ++e) {
+                ++stats.relaxed;
+                if (ignoreBlocked || !graph.isBlocked(current.id, e)) {
+                    uint32_t next = graph.targets[e];
+                    int newDist = current.priority + graph.weights[e];
+                    if (newDist < workspace.distance(next)) {
+                        workspace.set(next, newDist, current.id);
+                        if (pq.contains(next)) {
+                            pq.decreaseKey(next, newDist);
+                        } else {
+                            pq.insert(next, newDist);
+                        }
+                    }
+                }
+            }
+        }
+    }
 
-        LinkedList<string> queue;
-        LinkedList<string> visited;
+    // A* on the landmark potentials. Queue keys are distance plus lower bound, so the search
+    // settles nodes in order of their best possible total cost and skips nodes that
+    // provably can't reach the target.
+    void altSearch(CSRGraph& graph, LandmarkIndex& index, const RouteQuery& query, QueryWorkspace& workspace, RouteStats& stats) {
+        bool ignoreBlocked = query.blockedPolicy == IGNORE_BLOCKED;
+        NodeHeap<>& pq = workspace.heap;
+        int sourceBound = index.lowerBound(query.source, query.target);
+        if (sourceBound == INT_MAX) return;
+        workspace.set(query.source, 0, NO_NODE);
+        pq.insert(query.source, sourceBound);
+
+        while (!pq.isEmpty()) {
+            MinHeapNode<uint32_t> current = pq.extractMin();
+            if (current.priority > query.maxCost) break;
+            ++stats.settled;
+            if (current.id == query.target) break;
 
-        queue.enqueue(startId);
+            int currentDist = workspace.distance(current.id);
+            for (uint32_t e = graph.offsets[current.id]; e < graph.offsets[current.id + 1]; ++e) {
+                ++stats.relaxed;
+                if (ignoreBlocked || !graph.isBlocked(current.id, e)) {
+                    uint32_t next = graph.targets[e];
+                    int newDist = currentDist + graph.weights[e];
+                    if (newDist < workspace.distance(next)) {
+                        int bound = index.lowerBound(next, query.target);
+                        if (bound == INT_MAX) continue;
+                        workspace.set(next, newDist, current.id);
+                        pq.insert(next, newDist + bound);
+                    }
+                }
+            }
+        }
+    }
 
-        while (!queue.isEmpty()) {
-            string from = queue.dequeue();
+    // Dijkstra from one source that stops as soon as every node marked in isTarget is settled.
+    template <typename Queue>
+    void targetSearch(CSRGraph& graph, Queue& pq, uint32_t source, BlockedPolicy blockedPolicy,
+                      DynamicArray<uint8_t>& isTarget, int targetCount, QueryWorkspace& workspace, RouteStats& stats) {
+        bool ignoreBlocked = blockedPolicy == IGNORE_BLOCKED;
+        workspace.set(source, 0, NO_NODE);
+        pq.insert(source, 0);
 
-            if (!visited.containsString(from)) {
-                cout << from << " ";
-                visited.enqueue(from);
+        while (!pq.isEmpty() && targetCount > 0) {
+            MinHeapNode<uint32_t> current = pq.extractMin();
+            ++stats.settled;
+            if (isTarget[current.id]) {
+                --targetCount;
+            }
 
-                GraphNode* currentNode = findNode(from);
-                if (currentNode) {
-                    Node<Edge>* neighbor = currentNode->neighbors.head;
-                    while (neighbor) {
-                        if (!visited.containsString(neighbor->data.destination)) {
-                            queue.enqueue(neighbor->data.destination);
+            for (uint32_t e = graph.offsets[current.id]; e < graph.offsets[current.id + 1]; ++e) {
+                ++stats.relaxed;
+                if (ignoreBlocked || !graph.isBlocked(current.id, e)) {
+                    uint32_t next = graph.targets[e];
+                    int newDist = current.priority + graph.weights[e];
+                    if (newDist < workspace.distance(next)) {
+                        workspace.set(next, newDist, current.id);
+                        if (pq.contains(next)) {
+                            pq.decreaseKey(next, newDist);
+                        } else {
+                            pq.insert(next, newDist);
                         }
-                        neighbor = neighbor->next;
                     }
                 }
             }
         }
-        cout << endl;
     }
 
-    // Helper function for depth first searches
-    void dfsHelper(string nodeId, LinkedList<string>& visited) {
-        if (visited.containsString(nodeId)) {
-            return;
+    // Distances from every node to target over the reverse roads, INT_MAX if it can't get there.
+    void distancesTo(CSRGraph& graph, uint32_t target, BlockedPolicy blockedPolicy, DynamicArray<int>& out) {
+        bool ignoreBlocked = blockedPolicy == IGNORE_BLOCKED;
+        out.resize(graph.nodeCount());
+        out.fill(INT_MAX);
+        NodeHeap<> pq;
+        pq.positions.slots.resize(graph.nodeCount(), -1);
+        out[target] = 0;
+        pq.insert(target, 0);
+        while (!pq.isEmpty()) {
+            MinHeapNode<uint32_t> current = pq.extractMin();
+            for (uint32_t r = graph.reverseOffsets[current.id]; r < graph.reverseOffsets[current.id + 1]; ++r) {
+                uint32_t previous = graph.sources[r];
+                if (!ignoreBlocked && ((graph.reverseFlags[r] & EDGE_BLOCKED) || graph.isRed(previous))) continue;
+                int newDist = current.priority + graph.reverseWeights[r];
+                if (newDist < out[previous]) {
+                    out[previous] = newDist;
+                    pq.insert(previous, newDist);
+                }
+            }
         }
+    }
 
-        cout << nodeId << " ";
-        visited.enqueue(nodeId);
+    // A* from source to target that skips the nodes marked in removed and, at source only,
+    // the roads to any node in bannedNext. Yen's algorithm uses it for the spur paths. The
+    // distances to target without those removals are an exact potential for most nodes and a
+    // lower bound for all, so the search barely strays from the cheapest way around them.
+    void spurSearch(CSRGraph& graph, NodeHeap<>& pq, uint32_t source, uint32_t target, BlockedPolicy blockedPolicy,
+                    DynamicArray<uint8_t>& removed, DynamicArray<uint32_t>& bannedNext, DynamicArray<int>& toTarget,
+                    QueryWorkspace& workspace, RouteStats& stats) {
+        bool ignoreBlocked = blockedPolicy == IGNORE_BLOCKED;
+        if (toTarget[source] == INT_MAX) return;
+        workspace.set(source, 0, NO_NODE);
+        pq.insert(source, toTarget[source]);
 
-        GraphNode* node = findNode(nodeId);
-        if (node) {
-            Node<Edge>* neighbor = node->neighbors.head;
-            while (neighbor) {
-                if (!visited.containsString(neighbor->data.destination)) {
-                    dfsHelper(neighbor->data.destination, visited);
+        while (!pq.isEmpty()) {
+            MinHeapNode<uint32_t> current = pq.extractMin();
+            ++stats.settled;
+            if (current.id == target) break;
+
+            int currentDist = workspace.distance(current.id);
+            for (uint32_t e = graph.offsets[current.id]; e < graph.offsets[current.id + 1]; ++e) {
+                ++stats.relaxed;
+                uint32_t next = graph.targets[e];
+                if (removed[next] || toTarget[next] == INT_MAX || (!ignoreBlocked && graph.isBlocked(current.id, e))) continue;
+                if (current.id == source) {
+                    bool banned = false;
+                    for (int i = 0; i < bannedNext.size() && !banned; ++i) {
+                        banned = bannedNext[i] == next;
+                    }
+                    if (banned) continue;
+                }
+                int newDist = currentDist + graph.weights[e];
+                if (newDist < workspace.distance(next)) {
+                    workspace.set(next, newDist, current.id);
+                    pq.insert(next, newDist + toTarget[next]);
                 }
-                neighbor = neighbor->next;
             }
         }
     }
 
-    // Depth first search function
-    void dfs(string startId) {
-        LinkedList<string> visited;
-        dfsHelper(startId, visited);
-        cout << endl;
+    // Starts listing the loopless paths between two intersections within the given limits.
+    PathEnumerator enumeratePaths(uint32_t source, uint32_t target, BlockedPolicy blockedPolicy,
+                                  int maxCost = INT_MAX, int maxHops = INT_MAX, int maxPaths = INT_MAX) {
+        CSRGraph& graph = snapshot();
+        PathEnumerator paths(graph, source, target, blockedPolicy, maxCost, maxHops, maxPaths);
+        distancesTo(graph, target, blockedPolicy, paths.toTarget);
+        return paths;
     }
 
-    // Load blocked roads from a file
-    void loadBlocked(string filename) {
-        ifstream file(filename);
-        if (!file.is_open()) {
-            cout << "File doesn't exist.\n";
-            return;
+    // Counts the routes between two intersections that cost at most maxCost; see RouteCounter.
+    // COUNT_SATURATED stands for too many to count.
+    uint64_t countRoutes(uint32_t source, uint32_t target, int maxCost, BlockedPolicy blockedPolicy = AVOID_BLOCKED) {
+        CSRGraph& graph = snapshot();
+        if (!mayReach(source, target, blockedPolicy)) {
+            return 0;
         }
-        string line;
-        getline(file, line);
+        RouteCounter counter(graph, blockedPolicy);
+        distancesTo(graph, target, blockedPolicy, counter.toTarget);
+        return counter.count(source, target, maxCost);
+    }
 
-        while (getline(file, line)) {
-            stringstream ss(line);
-            string from, to, status;
-            if (getline(ss, from, ',') && getline(ss, to, ',') && getline(ss, status, ',')) {
-                if (status == "Blocked") {
-                    blockEdge(from, to);
-                }
+    // Counts the routes between two intersections that are as short as the shortest one.
+    // Counts that ignore blocks take the shortest cost from the contraction hierarchy.
+    uint64_t countShortestRoutes(uint32_t source, uint32_t target, BlockedPolicy blockedPolicy = AVOID_BLOCKED) {
+        RouteAlgorithm algorithm = blockedPolicy == IGNORE_BLOCKED ? CONTRACTION_HIERARCHY : DIJKSTRA;
+        RouteResult best = route(RouteQuery(source, target, blockedPolicy, INT_MAX, algorithm));
+        return best.found ? countRoutes(source, target, best.cost, blockedPolicy) : 0;
+    }
+
+    // Runs a multi-target search from source on the calling thread's workspace and returns
+    // the workspace, which holds the distances and parents of every settled target.
+    QueryWorkspace& searchTargets(uint32_t source, BlockedPolicy blockedPolicy, DynamicArray<uint32_t>& targets, RouteStats& stats,
+                                  QueueBackend backend = AUTO_QUEUE) {
+        CSRGraph& graph = snapshot();
+        QueryWorkspace& workspace = localWorkspace();
+        workspace.reset(nodes.size());
+        int targetCount = 0;
+        for (int i = 0; i < targets.size(); ++i) {
+            if (!workspace.marks[targets[i]]) {
+                workspace.marks[targets[i]] = 1;
+                ++targetCount;
             }
         }
-        file.close();
+        if (useBucketQueue(graph, backend)) {
+            targetSearch(graph, workspace.bucketQueue(nodes.size(), graph.maxWeight), source, blockedPolicy,
+                         workspace.marks, targetCount, workspace, stats);
+        } else {
+            targetSearch(graph, workspace.heap, source, blockedPolicy, workspace.marks, targetCount, workspace, stats);
+        }
+        for (int i = 0; i < targets.size(); ++i) {
+            workspace.marks[targets[i]] = 0;
+        }
+        return workspace;
     }
 
-    // Read road network inputs from csv
-    void loadNetwork(string filename) {
-        ifstream file(filename);
-        if (!file.is_open()) {
-            cout << "File doesn't exist.\n";
-            return;
+    // Fills row r of a matrix with one multi-target search from the row's source. targets
+    // holds the query's targets that exist; the search's work is added to stats.
+    void fillRow(const MatrixQuery& query, DynamicArray<uint32_t>& targets, DistanceMatrix& matrix, int r, RouteStats& stats) {
+        uint32_t source = query.sources[r];
+        QueryWorkspace& workspace = searchTargets(source, query.blockedPolicy, targets, stats, query.queue);
+        for (int c = 0; c < matrix.columns; ++c) {
+            uint32_t target = query.targets[c];
+            if (target >= (uint32_t)nodes.size()) continue;
+            matrix.cost(r, c) = workspace.distance(target);
+            if (query.withPaths) matrix.path(r, c) = buildPath(source, target, workspace);
+        }
+    }
+
+    // Computes the costs (and optionally paths) between every source and every target with one
+    // search per distinct source, spread over the routing pool. Rows of repeated sources are
+    // copied, not searched again.
+    DistanceMatrix distanceMatrix(const MatrixQuery& query) {
+        DistanceMatrix matrix(query.sources.size(), query.targets.size(), query.withPaths);
+        snapshot();
+        DynamicArray<uint32_t> targets;
+        for (int c = 0; c < matrix.columns; ++c) {
+            if (query.targets[c] < (uint32_t)nodes.size()) {
+                targets.pushBack(query.targets[c]);
+            }
         }
 
-        string line;
-        getline(file, line);
+        DynamicArray<int> firstRow(nodes.size(), -1);
+        DynamicArray<RouteStats> rowStats(matrix.rows);
+        ThreadPool& pool = routingPool();
+        for (int r = 0; r < matrix.rows; ++r) {
+            uint32_t source = query.sources[r];
+            if (source >= (uint32_t)nodes.size() || firstRow[source] >= 0) continue;
+            firstRow[source] = r;
+            pool.submit([this, &query, &matrix, &targets, &rowStats, r]() {
+                fillRow(query, targets, matrix, r, rowStats[r]);
+            });
+        }
+        pool.wait();
 
-        while (getline(file, line)) {
-            stringstream ss(line);
-            string from, to, weightStr;
-            int weight;
-            if (getline(ss, from, ',') && getline(ss, to, ',') && getline(ss, weightStr, ',')) {
-                weight = stoi(weightStr);
-                addNode(from);
-                addNode(to);
-                addEdge(from, to, weight);
+        for (int r = 0; r < matrix.rows; ++r) {
+            uint32_t source = query.sources[r];
+            if (source >= (uint32_t)nodes.size()) continue;
+            int first = firstRow[source];
+            if (first != r) {
+                for (int c = 0; c < matrix.columns; ++c) {
+                    matrix.cost(r, c) = matrix.cost(first, c);
+                    if (query.withPaths) matrix.path(r, c) = matrix.path(first, c);
+                }
             }
+            matrix.stats.settled += rowStats[r].settled;
+            matrix.stats.relaxed += rowStats[r].relaxed;
         }
-        file.close();
+        return matrix;
     }
 
-    // Read vehicles data from csv.
-    void loadVehicles(string filename) {
-        ifstream file(filename);
-        if (!file.is_open()) {
-            cout << "File doesn't exist.\n";
-            return;
+    // Answers a matrix query in hops instead of costs: the number of roads on the route with
+    // the fewest roads from every source to every target, INT_MAX where unreachable. Sources
+    // go through MultiSourceBfs 64 at a time, with the batches spread over the pool.
+    DistanceMatrix hopTable(const MatrixQuery& query) {
+        DistanceMatrix hops(query.sources.size(), query.targets.size());
+        CSRGraph& graph = snapshot();
+        DynamicArray<int> firstColumn(nodes.size(), -1);
+        DynamicArray<int> nextColumn(hops.columns, -1);
+        for (int c = hops.columns - 1; c >= 0; --c) {
+            uint32_t target = query.targets[c];
+            if (target >= (uint32_t)nodes.size()) continue;
+            nextColumn[c] = firstColumn[target];
+            firstColumn[target] = c;
         }
 
-        string line;
-        getline(file, line);
+        ThreadPool& pool = routingPool();
+        for (int first = 0; first < hops.rows; first += MultiSourceBfs::width) {
+            int count = hops.rows - first < MultiSourceBfs::width ? hops.rows - first : MultiSourceBfs::width;
+            pool.submit([&graph, &query, &firstColumn, &nextColumn, &hops, first, count]() {
+                MultiSourceBfs search(graph, query.blockedPolicy);
+                search.run(query, first, count, firstColumn, nextColumn, hops);
+            });
+        }
+        pool.wait();
+        return hops;
+    }
 
-        while (getline(file, line)) {
-            stringstream ss(line);
-            string id, from, to;
-            if (getline(ss, id, ',') && getline(ss, from, ',') && getline(ss, to, ',')) {
-                addVehicle(id, from, to);
+    // Serves the queries of one group (same source and blocked-road policy, chained through
+    // next) as a one-row matrix query on the first query's queue and writes their results.
+    void routeGroup(DynamicArray<RouteQuery>& queries, DynamicArray<int>& next, int first, DynamicArray<RouteResult>& results) {
+        MatrixQuery query(queries[first].blockedPolicy, true, queries[first].queue);
+        query.sources.pushBack(queries[first].source);
+        for (int i = first; i >= 0; i = next[i]) {
+            query.targets.pushBack(queries[i].target);
+        }
+        DistanceMatrix row(1, query.targets.size(), true);
+        fillRow(query, query.targets, row, 0, row.stats);
+        int c = 0;
+        for (int i = first; i >= 0; i = next[i], ++c) {
+            RouteResult& result = results[i];
+            int cost = row.cost(0, c);
+            result.stats = row.stats;
+            if (cost != INT_MAX && cost <= queries[i].maxCost) {
+                result.found = true;
+                result.cost = cost;
+                result.path.swapWith(row.path(0, c));
             }
         }
-        file.close();
     }
 
-    // Read emergency vehicles data from csv.
-    void loadEmergencyVehicles(string filename) {
-        ifstream file(filename);
-        if (!file.is_open()) {
-            cout << "File doesn't exist.\n";
-            return;
+    // Answers many point to point queries with one matrix row per distinct source and
+    // blocked-road policy, so the work grows with the number of origins, not of queries. Only
+    // DIJKSTRA queries share searches; any other algorithm goes through route() on its own. The
+    // searches run on the routing pool and write into a result array in query order. They
+    // start in order of priorities[i] (lowest first) when given, else in query order. Every
+    // result carries the stats of the search that served it.
+    DynamicArray<RouteResult> routeBatch(DynamicArray<RouteQuery>& queries, DynamicArray<int>* priorities = nullptr) {
+        DynamicArray<RouteResult> results(queries.size());
+        snapshot();
+        int n = nodes.size();
+        DynamicArray<int> groupHead(2 * n, -1);  // First query of every (source, policy)
+        DynamicArray<int> groupNext(queries.size(), -1);
+        DynamicArray<int> heads;
+        DynamicArray<int> singles;  // Queries routed on their own
+        for (int i = queries.size() - 1; i >= 0; --i) {
+            RouteQuery& query = queries[i];
+            if (query.source >= (uint32_t)n || query.target >= (uint32_t)n) continue;
+            if (query.algorithm != DIJKSTRA) {
+                // The indexes route() reads are built here, so the pool only reads them.
+                reachabilityIndex(query.blockedPolicy);
+                if (query.algorithm == ALT) landmarkIndex();
+                if (query.algorithm == CONTRACTION_HIERARCHY || query.algorithm == CUSTOMIZABLE_OVERLAY) {
+                    if (query.blockedPolicy == AVOID_BLOCKED) {
+                        routingOverlay();
+                    } else {
+                        hierarchy();
+                    }
+                }
+                singles.pushBack(i);
+                continue;
+            }
+            int key = query.source * 2 + query.blockedPolicy;
+            if (groupHead[key] < 0) heads.pushBack(key);
+            groupNext[i] = groupHead[key];
+            groupHead[key] = i;
+        }
+
+        // Groups are queued by their most urgent query, or by their first query without priorities.
+        NodeHeap<> order;
+        for (int h = 0; h < heads.size(); ++h) {
+            int first = groupHead[heads[h]];
+            int priority = first;
+            if (priorities) {
+                priority = INT_MAX;
+                for (int i = first; i >= 0; i = groupNext[i]) {
+                    if ((*priorities)[i] < priority) priority = (*priorities)[i];
+                }
+            }
+            order.insert(h, priority);
+        }
+        for (int k = 0; k < singles.size(); ++k) {
+            int i = singles[k];
+            order.insert(heads.size() + k, priorities ? (*priorities)[i] : i);
         }
+        ThreadPool& pool = routingPool();
+        while (!order.isEmpty()) {
+            int id = order.extractMin().id;
+            if (id >= heads.size()) {
+                int i = singles[id - heads.size()];
+                pool.submit([this, &queries, &results, i]() {
+                    results[i] = route(queries[i]);
+                });
+                continue;
+            }
+            int first = groupHead[heads[id]];
+            pool.submit([this, &queries, &groupNext, &results, first]() {
+                routeGroup(queries, groupNext, first, results);
+            });
+        }
+        pool.wait();
+        return results;
+    }
 
-        string line;
-        getline(file, line);
+    // Follows parents back from target. Returns an empty path if target wasn't reached.
+    DynamicArray<uint32_t> buildPath(uint32_t start, uint32_t target, QueryWorkspace& workspace) {
+        DynamicArray<uint32_t> path;
+        if (workspace.distance(target) == INT_MAX) {
+            return path;
+        }
+        uint32_t current = target;
+        while (current != start) {
+            path.pushBack(current);
+            current = workspace.parent(current);
+        }
+        path.pushBack(start);
+        reversePath(path);
+        return path;
+    }
 
-        while (getline(file, line)) {
-            stringstream ss(line);
-            string id, from, to, priority;
-            if (getline(ss, id, ',') && getline(ss, from, ',') && getline(ss, to, ',') && getline(ss,  priority, ',')) {
-                int priorityInt = (priority == "High")? 0 : (priority == "Medium")? 1 : (priority == "Low")? 2 : -1;
-                cout << "Inserting Emergency Vehicle: "
-     << id << " with priority " << priorityInt << endl;
-                emergencyVehicles.insert({id, from, to}, priorityInt);
+    // Settles the next node of one side of a bidirectional search. offsets/targets/weights/flags
+    // are the forward arrays for the forward side and the reverse arrays for the backward side.
+    // Every road looked at that reaches a node labelled by the other side is a candidate meeting.
+    template <typename Queue>
+    void settleSide(Queue& pq, QueryWorkspace& own, QueryWorkspace& other, bool ignoreBlocked,
+                    DynamicArray<uint32_t>& offsets, DynamicArray<uint32_t>& targets,
+                    DynamicArray<int>& weights, DynamicArray<uint8_t>& flags, bool backward,
+                    long long& best, uint32_t& meeting, RouteStats& stats) {
+        MinHeapNode<uint32_t> current = pq.extractMin();
+        ++stats.settled;
+        for (uint32_t e = offsets[current.id]; e < offsets[current.id + 1]; ++e) {
+            ++stats.relaxed;
+            uint32_t next = targets[e];
+            if (!ignoreBlocked && ((flags[e] & EDGE_BLOCKED) || csr.isRed(backward ? next : current.id))) {
+                continue;
+            }
+            int newDist = current.priority + weights[e];
+            if (newDist < own.distance(next)) {
+                own.set(next, newDist, current.id);
+                if (pq.contains(next)) {
+                    pq.decreaseKey(next, newDist);
+                } else {
+                    pq.insert(next, newDist);
+                }
+            }
+            int otherDist = other.distance(next);
+            if (otherDist != INT_MAX && (long long)newDist + otherDist < best) {
+                best = (long long)newDist + otherDist;
+                meeting = next;
             }
         }
-        file.close();
     }
 
-    // Read signals data from csv.
-    void loadSignals(string filename) {
-        ifstream file(filename);
-        if (!file.is_open()) {
-            cout << "File doesn't exist.\n";
+    // Bidirectional Dijkstra: grows a forward search from the source and a backward search
+    // from the target, always expanding the side with the smaller queue, and stops once the
+    // two queue minima together cannot beat the best meeting found so far.
+    template <typename Queue>
+    void bidirectionalSearch(CSRGraph& graph, Queue& forwardQueue, Queue& backwardQueue, const RouteQuery& query,
+                             QueryWorkspace& forward, QueryWorkspace& backward,
+                             long long& best, uint32_t& meeting, RouteStats& stats) {
+        bool ignoreBlocked = query.blockedPolicy == IGNORE_BLOCKED;
+        forward.set(query.source, 0, NO_NODE);
+        backward.set(query.target, 0, NO_NODE);
+        forwardQueue.insert(query.source, 0);
+        backwardQueue.insert(query.target, 0);
+        best = LLONG_MAX;
+        meeting = NO_NODE;
+        if (query.source == query.target) {
+            best = 0;
+            meeting = query.source;
             return;
         }
 
-        string line;
-        getline(file, line);
+        while (!forwardQueue.isEmpty() && !backwardQueue.isEmpty()) {
+            long long bound = (long long)forwardQueue.peekMin().priority + backwardQueue.peekMin().priority;
+            if (bound >= best || bound > query.maxCost) break;
 
-        while (getline(file, line)) {
-            stringstream ss(line);
-            string intersection, greenTime;
-            if (getline(ss, intersection, ',') && getline(ss, greenTime, ',')) {
-                GraphNode* node = findNode(intersection);
-                if (node) {
-                    node->greenTime = stoi(greenTime);
-                }
+            if (forwardQueue.size() <= backwardQueue.size()) {
+                settleSide(forwardQueue, forward, backward, ignoreBlocked, graph.offsets, graph.targets,
+                           graph.weights, graph.flags, false, best, meeting, stats);
+            } else {
+                settleSide(backwardQueue, backward, forward, ignoreBlocked, graph.reverseOffsets, graph.sources,
+                           graph.reverseWeights, graph.reverseFlags, true, best, meeting, stats);
             }
         }
-        file.close();
     }
-    // Loads all csv files.
-    void load() {
-        loadNetwork("road_network.csv");
-        loadBlocked("road_closures.csv");
-        loadVehicles("vehicles.csv");
-        loadEmergencyVehicles("emergency_vehicles.csv");
-        loadSignals("traffic_signals.csv");
+
+    // Joins the forward parents up to the meeting node with the backward parents after it.
+    DynamicArray<uint32_t> buildPath(uint32_t start, uint32_t meeting, QueryWorkspace& forward, QueryWorkspace& backward) {
+        DynamicArray<uint32_t> path = buildPath(start, meeting, forward);
+        for (uint32_t current = backward.parent(meeting); current != NO_NODE; current = backward.parent(current)) {
+            path.pushBack(current);
+        }
+        return path;
     }
 
-    // Dijkstras algorithm for finding the shortest path.
-    void dijkstra(string startId, string targetId, bool ignoreBlocked = 0) {
-        if (!findNode(startId) || !findNode(targetId)) {
-            cout << "One or both nodes do not exist!" << endl;
-            return;
+    // Answers a query with bidirectional Dijkstra.
+    RouteResult routeBidirectional(const RouteQuery& query, CSRGraph& graph) {
+        RouteResult result;
+        QueryWorkspace& forward = localWorkspace(0);
+        QueryWorkspace& backward = localWorkspace(1);
+        forward.reset(nodes.size());
+        backward.reset(nodes.size());
+
+        long long best;
+        uint32_t meeting;
+        if (useBucketQueue(graph, query.queue)) {
+            bidirectionalSearch(graph, forward.bucketQueue(nodes.size(), graph.maxWeight),
+                                backward.bucketQueue(nodes.size(), graph.maxWeight), query,
+                                forward, backward, best, meeting, result.stats);
+        } else {
+            bidirectionalSearch(graph, forward.heap, backward.heap, query, forward, backward, best, meeting, result.stats);
+        }
+
+        if (meeting != NO_NODE && best <= query.maxCost) {
+            result.found = true;
+            result.cost = (int)best;
+            result.path = buildPath(query.source, meeting, forward, backward);
         }
+        return result;
+    }
 
-        MinHeap<string> pq;
-        HashTable<int> distances;
-        HashTable<string> predecessors;
+    // The routing engine: answers a point to point query without printing anything.
+    RouteResult route(const RouteQuery& query) {
+        if (query.source >= (uint32_t)nodes.size() || query.target >= (uint32_t)nodes.size()) {
+            return RouteResult();
+        }
 
-        for (int i = 0; i < sizeX; ++i) {
-            if (vertices.arr[i].occupied) {
-                distances[vertices.arr[i].data.id] = INT_MAX;
-                predecessors[vertices.arr[i].data.id] = "";
+        CSRGraph& graph = snapshot();
+        if (!mayReach(query.source, query.target, query.blockedPolicy)) {
+            return RouteResult();
+        }
+        if (query.algorithm == BIDIRECTIONAL_DIJKSTRA) {
+            return routeBidirectional(query, graph);
+        }
+        if (query.algorithm == CONTRACTION_HIERARCHY || query.algorithm == CUSTOMIZABLE_OVERLAY) {
+            // Closures and signals change the metric of regular traffic all the time, so the
+            // overlay answers it; emergencies drive every road, which the hierarchy covers.
+            if (query.blockedPolicy == AVOID_BLOCKED) {
+                return routingOverlay().query(graph, query);
             }
+            return hierarchy().query(query);
         }
 
-        distances[startId] = 0;
-        pq.insert(startId, 0);
+        RouteResult result;
+        QueryWorkspace& workspace = localWorkspace();
+        workspace.reset(nodes.size());
 
-        while (!pq.isEmpty()) {
-            MinHeapNode<string> current = pq.getMin();
-            if (current.id == targetId) break;
-
-            GraphNode* node = findNode(current.id);
-            if (!node) continue;
-
-            Node<Edge>* neighbor = node->neighbors.head;
-            while (neighbor) {
-                Edge& edge = neighbor->data;
-                if (ignoreBlocked || !edge.blocked) { // Updated condition
-                    int newDist = distances[current.id] + edge.weight;
-                    if (newDist < distances[edge.destination]) {
-                        distances[edge.destination] = newDist;
-                        predecessors[edge.destination] = current.id;
-                        pq.insert(edge.destination, newDist);
+        if (query.algorithm == ALT) {
+            // Potentials can shift keys by more than one road weight, so ALT always runs on the heap.
+            altSearch(graph, landmarkIndex(), query, workspace, result.stats);
+        } else if (useBucketQueue(graph, query.queue)) {
+            dijkstraSearch(graph, workspace.bucketQueue(nodes.size(), graph.maxWeight), query, workspace, result.stats);
+        } else {
+            dijkstraSearch(graph, workspace.heap, query, workspace, result.stats);
+        }
+
+        int cost = workspace.distance(query.target);
+        if (cost != INT_MAX && cost <= query.maxCost) {
+            result.found = true;
+            result.cost = cost;
+            result.path = buildPath(query.source, query.target, workspace);
+        }
+        return result;
+    }
+
+    // Returns up to k loopless routes from source to target, cheapest first (Yen's algorithm).
+    // Each route after the first branches off the previous one at some spur node: the part up
+    // to the spur is kept, the roads earlier routes took out of it with the same prefix and the
+    // prefix's own nodes are removed, and the cheapest rest of the way becomes a candidate.
+    // The cheapest candidate not yet listed is the next route. The work grows with k and the
+    // route length, not with the number of routes in the network.
+    DynamicArray<RouteResult> kShortestPaths(uint32_t source, uint32_t target, int k, BlockedPolicy blockedPolicy = AVOID_BLOCKED) {
+        DynamicArray<RouteResult> routes;
+        if (k <= 0) {
+            return routes;
+        }
+        RouteResult first = route(RouteQuery(source, target, blockedPolicy));
+        if (!first.found) {
+            return routes;
+        }
+        CSRGraph& graph = snapshot();
+        DynamicArray<int> toTarget;
+        distancesTo(graph, target, blockedPolicy, toTarget);
+        DynamicArray<RouteResult> candidates;
+        NodeHeap<> order;            // Candidate indices by cost
+        HashTable<int> listed;       // Every route already listed or waiting as a candidate
+        listed.insert(pathKey(first.path), 0);
+        routes.pushBack(first);
+
+        DynamicArray<uint32_t> previous;
+        DynamicArray<int> sharedPrefix;  // Nodes every route shares with the previous one
+        DynamicArray<uint32_t> bannedNext;
+        while (routes.size() < k) {
+            previous = routes[routes.size() - 1].path;
+            sharedPrefix.clear();
+            for (int r = 0; r < routes.size(); ++r) {
+                DynamicArray<uint32_t>& path = routes[r].path;
+                int shared = 0;
+                while (shared < path.size() && shared < previous.size() && path[shared] == previous[shared]) {
+                    ++shared;
+                }
+                sharedPrefix.pushBack(shared);
+            }
+
+            int rootCost = 0;
+            for (int j = 0; j + 1 < previous.size(); ++j) {
+                uint32_t spur = previous[j];
+                bannedNext.clear();
+                for (int r = 0; r < routes.size(); ++r) {
+                    if (sharedPrefix[r] > j && routes[r].path.size() > j + 1) {
+                        bannedNext.pushBack(routes[r].path[j + 1]);
+                    }
+                }
+
+                QueryWorkspace& workspace = localWorkspace();
+                workspace.reset(nodes.size());
+                for (int i = 0; i < j; ++i) {
+                    workspace.marks[previous[i]] = 1;
+                }
+                RouteStats stats;
+                spurSearch(graph, workspace.heap, spur, target, blockedPolicy, workspace.marks, bannedNext, toTarget, workspace, stats);
+                for (int i = 0; i < j; ++i) {
+                    workspace.marks[previous[i]] = 0;
+                }
+
+                if (workspace.distance(target) != INT_MAX) {
+                    RouteResult candidate;
+                    candidate.found = true;
+                    candidate.cost = rootCost + workspace.distance(target);
+                    candidate.stats = stats;
+                    for (int i = 0; i < j; ++i) {
+                        candidate.path.pushBack(previous[i]);
+                    }
+                    DynamicArray<uint32_t> spurPath = buildPath(spur, target, workspace);
+                    for (int i = 0; i < spurPath.size(); ++i) {
+                        candidate.path.pushBack(spurPath[i]);
+                    }
+                    string key = pathKey(candidate.path);
+                    if (!listed.contains(key)) {
+                        listed.insert(key, candidates.size());
+                        order.insert(candidates.size(), candidate.cost);
+                        candidates.pushBack(candidate);
                     }
                 }
-                neighbor = neighbor->next;
+                rootCost += graph.weights[graph.findSlot(spur, previous[j + 1])];
             }
-        }
 
-        if (distances[targetId] == INT_MAX) {
-            cout << "No path to " << targetId << endl;
-        } else {
-            LinkedList<string> path;
-            string current = targetId;
-            while (current != startId) {
-                path.enqueue(current);
-                current = predecessors[current];
+            if (order.isEmpty()) {
+                break;
             }
-            path.enqueue(startId);
-            path.reverse();
+            routes.pushBack(candidates[order.extractMin().id]);
+        }
+        return routes;
+    }
 
-            cout << "Shortest path (Dijkstra): ";
-            path.display();
-            cout << "\nTotal weight: " << distances[targetId] << endl;
+    // Identifies a path by its node indices, for telling routes apart.
+    string pathKey(DynamicArray<uint32_t>& path) {
+        string key;
+        for (int i = 0; i < path.size(); ++i) {
+            key += to_string(path[i]) + ",";
         }
+        return key;
     }
-    // Show shortest path for all emergency vehicles, ignoring all traffick lights.
-    void showEmergencyVehiclePaths() {
-        cout << "------ All Emergency Vehicle Shortest Paths ------" << endl;
-        Node<MinHeapNode<Vehicles>> *current = emergencyVehicles.heap.head;
-        while (current) {
-            MinHeapNode<Vehicles>& vehicleNode = current->data;
-            Vehicles& vehicle = vehicleNode.id;
-            cout << "Emergency Vehicle " << vehicle.id << " from " << vehicle.start << " to " << vehicle.end << ":" << endl;
-            dijkstra(vehicle.start, vehicle.end, true);
-            cout << endl;
-            current = current->next;
+
+    // Prints the cheapest few routes between two intersections, ignoring blocked roads.
+    void showAlternativeRoutes(string from, string to, int k) {
+        uint32_t start = indexOf(from);
+        uint32_t end = indexOf(to);
+        if (start == NO_NODE || end == NO_NODE) {
+            cout << "Start or end node not found!" << endl;
+            return;
+        }
+
+        DynamicArray<RouteResult> routes = kShortestPaths(start, end, k, IGNORE_BLOCKED);
+        if (routes.isEmpty()) {
+            cout << "No path found from " << from << " to " << to << endl;
+        }
+        for (int i = 0; i < routes.size(); ++i) {
+            cout << "Path " << i + 1 << ": ";
+            printPath(routes[i].path);
+            cout << " | Total Weight: " << routes[i].cost << endl;
         }
     }
 
-    // Show all shortest paths for all vehicles.
-    void showVehiclePaths() {
-        Node<Vehicles>* current = vehicles.head;
-        while (current) {
-            Vehicles vehicle = current->data;
-            if (vehicle.start.empty() || vehicle.end.empty()) {
-                cout << "Invalid vehicle data: " << vehicle.id << endl;
-                current = current->next;
-                continue;
-            }
+    // Prints every loopless route between two intersections up to a cost, ignoring blocked
+    // roads, stopping after auditPathLimit routes.
+    void showPathAudit(string from, string to, int maxCost) {
+        uint32_t start = indexOf(from);
+        uint32_t end = indexOf(to);
+        if (start == NO_NODE || end == NO_NODE) {
+            cout << "Start or end node not found!" << endl;
+            return;
+        }
 
-            GraphNode* start = findNode(vehicle.start);
-            GraphNode* end = findNode(vehicle.end);
+        PathEnumerator paths = enumeratePaths(start, end, IGNORE_BLOCKED, maxCost, INT_MAX, auditPathLimit);
+        while (paths.next()) {
+            cout << "Path: ";
+            printPath(paths.path);
+            cout << " | Total Weight: " << paths.cost << endl;
+        }
+        if (paths.found == 0) {
+            cout << "No path found from " << from << " to " << to << " within " << maxCost << endl;
+        } else if (paths.found == auditPathLimit) {
+            cout << "Stopped after " << auditPathLimit << " paths.\n";
+        }
+    }
 
-            if (start && end) {
-                cout << "Shortest path for vehicle " << vehicle.id << " from " << vehicle.start << " to " << vehicle.end << ":" << endl;
-                dijkstra(vehicle.start, vehicle.end);
-                cout << endl;
-            }
+    // Warns if closing the road from -> to would cut intersections off from from.
+    void showClosureImpact(string from, string to) {
+        uint32_t start = indexOf(from);
+        uint32_t end = indexOf(to);
+        if (start == NO_NODE || end == NO_NODE || !getEdge(start, end)) return;
+        uint32_t cutOff = closureImpact(start, end);
+        if (cutOff > 0) {
+            cout << "Warning: closing " << from << " to " << to << " cuts " << cutOff << " intersection(s) off from " << from << ".\n";
+        } else {
+            cout << "Closing " << from << " to " << to << " leaves every intersection " << from << " reaches reachable.\n";
+        }
+    }
 
-            current = current->next;
+    // Prints how many routes between two intersections cost at most maxCost and how many of
+    // them are shortest routes, ignoring blocked roads.
+    void showRouteCount(string from, string to, int maxCost) {
+        uint32_t start = indexOf(from);
+        uint32_t end = indexOf(to);
+        if (start == NO_NODE || end == NO_NODE) {
+            cout << "Start or end node not found!" << endl;
+            return;
         }
+
+        int builds = hierarchyBuilds;
+        uint64_t within = countRoutes(start, end, maxCost, IGNORE_BLOCKED);
+        uint64_t shortest = countShortestRoutes(start, end, IGNORE_BLOCKED);
+        if (hierarchyBuilds != builds) {
+            cout << "Contraction hierarchy built in " << contraction.buildMillis << " ms with "
+                 << contraction.shortcuts << " shortcuts.\n";
+        }
+        cout << "Routes from " << from << " to " << to << " within " << maxCost << ": ";
+        printCount(within);
+        cout << "\nShortest routes: ";
+        printCount(shortest);
+        cout << endl;
+    }
+
+    void printCount(uint64_t count) {
+        if (count == COUNT_SATURATED) {
+            cout << "too many to count";
+        } else {
+            cout << count;
+        }
+    }
+
+    // Prints the outcome of a route, labelled with the algorithm that found it.
+    void printRoute(RouteResult& result, uint32_t target, RouteAlgorithm algorithm) {
+        if (!result.found) {
+            cout << "No path to " << nameOf(target) << '\n';
+        } else {
+            cout << "Shortest path (" << algorithmName(algorithm) << "): ";
+            printPath(result.path);
+            cout << "\nTotal weight: " << result.cost << '\n';
+        }
+    }
+
+    // Prints the travel time from one intersection to every other one. The intersection is
+    // watched from then on, so asking again only costs the repairs since the last time.
+    void showTravelTimes(string startId) {
+        uint32_t start = indexOf(startId);
+        if (start == NO_NODE) {
+            cout << "Node '" << startId << "' doesn't exist.\n";
+            return;
+        }
+        ShortestPathTree& tree = sourceTree(watchSource(start));
+        cout << "------ Travel Times from " << startId << " ------" << '\n';
+        for (int i = 0; i < nodes.size(); ++i) {
+            cout << startId << " to " << nameOf(i) << " -> ";
+            if (tree.distances[i] == INT_MAX) {
+                cout << "unreachable\n";
+            } else {
+                cout << tree.distances[i] << '\n';
+            }
+        }
+        cout.flush();
     }
-    // Displays vehicle counts.
-    void showCongestion() {
-        cout << "------ Congestion Status ------" << endl;
 
-        for (int i = 0; i < sizeX; ++i) {
-            if (vertices.arr[i].occupied) {
-                GraphNode& node = vertices.arr[i].data;
-                Node<Edge>* current = node.neighbors.head;
+    // Prints how many roads the route with the fewest roads takes from one intersection to
+    // every other one right now, avoiding closed roads and red signals.
+    void showHopCounts(string startId) {
+        uint32_t start = indexOf(startId);
+        if (start == NO_NODE) {
+            cout << "Node '" << startId << "' doesn't exist.\n";
+            return;
+        }
+        BreadthFirstSearch search = breadthFirst(start);
+        cout << "------ Hop Counts from " << startId << " ------" << '\n';
+        for (int i = 0; i < nodes.size(); ++i) {
+            cout << startId << " to " << nameOf(i) << " -> ";
+            if (search.levels[i] == INT_MAX) {
+                cout << "unreachable\n";
+            } else {
+                cout << search.levels[i] << " road(s)\n";
+            }
+        }
+        cout.flush();
+    }
 
-                // Traverse all edges of the current vertex
-                while (current) {
-                    cout << node.id << " to " << current->data.destination << " -> Vehicles: " << current->data.vehicles << endl;
-                    current = current->next;
+    // Prints the hop count between every pair of intersections as a table, one row per
+    // start, avoiding closed roads and red signals. "-" marks an unreachable pair.
+    void showHopTable() {
+        MatrixQuery query;
+        for (int i = 0; i < nodes.size(); ++i) {
+            query.sources.pushBack(i);
+            query.targets.pushBack(i);
+        }
+        DistanceMatrix hops = hopTable(query);
+        cout << "------ Hop Table ------" << '\n';
+        cout << "From\\To";
+        for (int c = 0; c < hops.columns; ++c) {
+            cout << '\t' << nameOf(c);
+        }
+        cout << '\n';
+        for (int r = 0; r < hops.rows; ++r) {
+            cout << nameOf(r);
+            for (int c = 0; c < hops.columns; ++c) {
+                cout << '\t';
+                if (hops.cost(r, c) == INT_MAX) {
+                    cout << '-';
+                } else {
+                    cout << hops.cost(r, c);
                 }
             }
+            cout << '\n';
         }
+        cout.flush();
     }
 
+    // Finds and prints the shortest route between two intersections given by name.
+    void showRoute(string startId, string targetId, BlockedPolicy blockedPolicy = AVOID_BLOCKED,
+                   RouteAlgorithm algorithm = DIJKSTRA) {
+        uint32_t start = indexOf(startId);
+        uint32_t target = indexOf(targetId);
+        if (start == NO_NODE || target == NO_NODE) {
+            cout << "One or both nodes do not exist!" << endl;
+            return;
+        }
+        RouteResult result = route(RouteQuery(start, target, blockedPolicy, INT_MAX, algorithm));
+        printRoute(result, target, algorithm);
+        cout.flush();
+    }
 
-    // Function to return a list of the shortest path using Dijkstra's algorithm
-    LinkedList<string> findShortestPath(string startId, string targetId) {
-        MinHeap<string> pq;
-        HashTable<int> distances;
-        HashTable<string> predecessors;
+    // Appends a query per emergency vehicle, in load order, with the vehicle's priority.
+    // Emergencies are point to point runs, so they use bidirectional Dijkstra.
+    void addEmergencyQueries(DynamicArray<RouteQuery>& queries, DynamicArray<int>& priorities) {
+        for (int i = 0; i < emergencyArrivals.size(); ++i) {
+            Vehicles& vehicle = emergencyArrivals[i];
+            queries.pushBack(RouteQuery(vehicle.start, vehicle.end, IGNORE_BLOCKED, INT_MAX, BIDIRECTIONAL_DIJKSTRA));
+            priorities.pushBack(emergencyVehicles.priorityOf(vehicle));
+        }
+    }
 
-        // Initialize distances and predecessors
-        for (int i = 0; i < sizeX; ++i) {
-            if (vertices.arr[i].occupied) {
-                distances[vertices.arr[i].data.id] = INT_MAX;
-                predecessors[vertices.arr[i].data.id] = "";
-            }
+    // Appends a query per regular vehicle, in list order, behind every emergency.
+    void addVehicleQueries(DynamicArray<RouteQuery>& queries, DynamicArray<int>& priorities) {
+        for (Node<Vehicles>* current = vehicles.head; current; current = current->next) {
+            queries.pushBack(RouteQuery(current->data.start, current->data.end));
+            priorities.pushBack(INT_MAX);
         }
+    }
 
-        distances[startId] = 0;
-        pq.insert(startId, 0);
+    // Prints the emergency vehicle routes that start at results[first].
+    void printEmergencyRoutes(DynamicArray<RouteQuery>& queries, DynamicArray<RouteResult>& results, int first) {
+        cout << "------ All Emergency Vehicle Shortest Paths ------" << '\n';
+        for (int i = 0; i < emergencyArrivals.size(); ++i) {
+            Vehicles& vehicle = emergencyArrivals[i];
+            cout << "Emergency Vehicle " << vehicle.id << " from " << nameOf(vehicle.start) << " to " << nameOf(vehicle.end) << ":" << '\n';
+            printRoute(results[first + i], vehicle.end, queries[first + i].algorithm);
+            cout << '\n';
+        }
+        cout.flush();
+    }
 
-        while (!pq.isEmpty()) {
-            MinHeapNode<string> current = pq.getMin();
-            if (current.id == targetId) break;
-
-            GraphNode* node = findNode(current.id);
-            if (!node) continue;
-
-            Node<Edge>* neighbor = node->neighbors.head;
-            while (neighbor) {
-                Edge& edge = neighbor->data;
-                if (!edge.blocked) {
-                    int newDist = distances[current.id] + edge.weight;
-                    if (newDist < distances[edge.destination]) {
-                        distances[edge.destination] = newDist;
-                        predecessors[edge.destination] = current.id;
-                        pq.insert(edge.destination, newDist);
-                    }
-                }
-                neighbor = neighbor->next;
+    // Prints the regular vehicle routes that start at results[first].
+    void printVehicleRoutes(DynamicArray<RouteQuery>& queries, DynamicArray<RouteResult>& results, int first) {
+        int i = first;
+        for (Node<Vehicles>* current = vehicles.head; current; current = current->next, ++i) {
+            Vehicles& vehicle = current->data;
+            if (vehicle.start == NO_NODE || vehicle.end == NO_NODE) {
+                cout << "Invalid vehicle data: " << vehicle.id << '\n';
+                continue;
             }
+
+            cout << "Shortest path for vehicle " << vehicle.id << " from " << nameOf(vehicle.start) << " to " << nameOf(vehicle.end) << ":" << '\n';
+            printRoute(results[i], vehicle.end, queries[i].algorithm);
+            cout << '\n';
         }
+        cout.flush();
+    }
+
+    // Show shortest path for all emergency vehicles, ignoring all traffick lights.
+    void showEmergencyVehiclePaths() {
+        DynamicArray<RouteQuery> queries;
+        DynamicArray<int> priorities;
+        addEmergencyQueries(queries, priorities);
+        DynamicArray<RouteResult> results = routeBatch(queries, &priorities);
+        printEmergencyRoutes(queries, results, 0);
+    }
+
+    // Show all shortest paths for all vehicles.
+    void showVehiclePaths() {
+        DynamicArray<RouteQuery> queries;
+        DynamicArray<int> priorities;
+        addVehicleQueries(queries, priorities);
+        DynamicArray<RouteResult> results = routeBatch(queries);
+        printVehicleRoutes(queries, results, 0);
+    }
 
-        // Reconstruct the path
-        LinkedList<string> path;
-        string current = targetId;
-        while (!current.empty() && current != startId) {
-            path.push(current);
-            current = predecessors[current];
+    // Routes the whole fleet in one parallel batch, emergencies first by priority, then
+    // prints both lists in their usual order.
+    void showFleetPaths() {
+        DynamicArray<RouteQuery> queries;
+        DynamicArray<int> priorities;
+        addEmergencyQueries(queries, priorities);
+        int firstVehicle = queries.size();
+        addVehicleQueries(queries, priorities);
+        DynamicArray<RouteResult> results = routeBatch(queries, &priorities);
+        printEmergencyRoutes(queries, results, 0);
+        printVehicleRoutes(queries, results, firstVehicle);
+    }
+
+    // Displays vehicle counts.
+    void showCongestion() {
+        cout << "------ Congestion Status ------" << endl;
+
+        for (int i = 0; i < nodes.size(); ++i) {
+            GraphNode& node = nodes[i];
+            Node<Edge>* current = node.neighbors.head;
+
+            // Traverse all edges of the current vertex
+            while (current) {
+                cout << node.id << " to " << nameOf(current->data.destination) << " -> Vehicles: " << current->data.vehicles << endl;
+                current = current->next;
+            }
         }
-        if (!current.empty()) {
-            path.push(startId);
-        } else {
-            // No path found
-            return LinkedList<string>();
+    }
+
+    // Reverses a path in place.
+    void reversePath(DynamicArray<uint32_t>& path) {
+        for (int i = 0, j = path.size() - 1; i < j; ++i, --j) {
+            uint32_t temp = path[i];
+            path[i] = path[j];
+            path[j] = temp;
         }
-        return path;
     }
 
     // Add a vehicle and increase the count of each edge on the shortest path from that edge.
     void addVehicle(string id, string from, string to) {
-        LinkedList<string> path = findShortestPath(from, to);
-        if (!path.isEmpty()) {
-            Node<string>* current = path.head;
-            Node<string>* next = current->next;
-            while (next) {
-                string start = current->data;
-                string end = next->data;
-                Edge* road = getEdge(start, end);
+        uint32_t start = indexOf(from);
+        uint32_t end = indexOf(to);
+        RouteResult result;
+        if (start != NO_NODE && end != NO_NODE) {
+            result = route(RouteQuery(start, end, AVOID_BLOCKED, INT_MAX, CUSTOMIZABLE_OVERLAY));
+        }
+        DynamicArray<uint32_t>& path = result.path;
+        if (result.found) {
+            for (int i = 0; i + 1 < path.size(); ++i) {
+                Edge* road = getEdge(path[i], path[i + 1]);
                 if (road) {
                     road->vehicles++;
                 } else {
-                    cout << "No direct road from " << start << " to " << end << endl;
+                    cout << "No direct road from " << nameOf(path[i]) << " to " << nameOf(path[i + 1]) << endl;
                 }
-                current = next;
-                next = next->next;
             }
-            vehicles.enqueue(Vehicles(id, from, to));
+            vehicles.enqueue(Vehicles(id, start, end));
             cout << "Added Vehicle: " << id << " along path: ";
-            path.display();
+            printPath(path);
             cout << endl;
         } else {
             cout << "No path found for vehicle " << id << " from " << from << " to " << to << endl;
         }
     }
 
-    // Toggle all roads blocked status when greenTime is up
-    void changeTrafficLights() {
-        for (int i = 0; i < sizeX; ++i) {
-            if (vertices.arr[i].occupied) {
-                GraphNode& node = vertices.arr[i].data;
-                if (timer % node.greenTime == 0) {
-                    Node<Edge>* current = node.neighbors.head;
-                    while (current) {
-                        current->data.blocked = !current->data.blocked;
-                        current = current->next;
-                    }
-                }
-            }
-        }
+    // Advances the simulation clock. Signals are worked out from the time whenever a road is
+    // looked at, so a tick touches no roads.
+    void tick(int seconds) {
+        timer += seconds;
     }
 
     // Display the menu.
@@ -1004,6 +5148,13 @@ public:
             cout << "11. Add road between intersections.\n";
             cout << "12. Show all shortest paths for all vehicles.\n";
             cout << "13. Show all shortest paths for all emergency vehicles.\n";
+            cout << "14. Show all shortest paths for the whole fleet.\n";
+            cout << "15. Show travel times from an intersection.\n";
+            cout << "16. List all routes between two intersections up to a cost.\n";
+            cout << "17. Count routes between two intersections up to a cost.\n";
+            cout << "18. Show hop counts from an intersection.\n";
+            cout << "19. Show hop counts between all intersections.\n";
+            cout << "20. Find the shortest route between two intersections.\n";
             cout << "80. Exit Simulation\n";
             cout << "Enter your choice: \n";
             int n;
@@ -1029,13 +5180,14 @@ public:
                     cout << "Enter start and end intersections for emergency vehicle.\n";
                     string start, end;
                     cin >> start >> end;
-                    dijkstra(start, end, 1);
+                    showRoute(start, end, IGNORE_BLOCKED, BIDIRECTIONAL_DIJKSTRA);
                     break;
                 }
                 case 6: {
                     cout << "Enter road to block (start, end): ";
                     string start, end;
                     cin >> start >> end;
+                    showClosureImpact(start, end);
                     blockEdge(start, end);
                     break;
                 }
@@ -1046,8 +5198,8 @@ public:
                     cin >> start;
                     cout << "Enter ending intersection: ";
                     cin >> end;
-                    cout << "All possible paths from A to F are:\n";
-                    findAllPaths(start, end);
+                    cout << "The " << alternativeCount << " shortest paths from " << start << " to " << end << " are:\n";
+                    showAlternativeRoutes(start, end, alternativeCount);
                     break;
                 }
                 case 8: {
@@ -1091,21 +5243,76 @@ public:
                     showEmergencyVehiclePaths();
                     break;
                 }
+                case 14: {
+                    showFleetPaths();
+                    break;
+                }
+                case 15: {
+                    string start;
+                    cout << "Enter starting intersection: ";
+                    cin >> start;
+                    showTravelTimes(start);
+                    break;
+                }
+                case 16: {
+                    string start, end;
+                    int maxCost;
+                    cout << "Enter starting intersection: ";
+                    cin >> start;
+                    cout << "Enter ending intersection: ";
+                    cin >> end;
+                    cout << "Enter maximum travel time: ";
+                    cin >> maxCost;
+                    showPathAudit(start, end, maxCost);
+                    break;
+                }
+                case 17: {
+                    string start, end;
+                    int maxCost;
+                    cout << "Enter starting intersection: ";
+                    cin >> start;
+                    cout << "Enter ending intersection: ";
+                    cin >> end;
+                    cout << "Enter maximum travel time: ";
+                    cin >> maxCost;
+                    showRouteCount(start, end, maxCost);
+                    break;
+                }
+                case 18: {
+                    string start;
+                    cout << "Enter starting intersection: ";
+                    cin >> start;
+                    showHopCounts(start);
+                    break;
+                }
+                case 19: {
+                    showHopTable();
+                    break;
+                }
+                case 20: {
+                    cout << "Enter start and end intersections: ";
+                    string start, end;
+                    cin >> start >> end;
+                    showRoute(start, end, AVOID_BLOCKED, ALT);
+                    break;
+                }
                 case 80: {
                     quit = false;
                     break;
                 }
             }
-            this->timer += 10;
-            this->changeTrafficLights();
+            this->tick(10);
         }
     }
 };
 
 
+// The tests include this file with TRAFFIC_SIMULATION_NO_MAIN defined and bring their own main.
+#ifndef TRAFFIC_SIMULATION_NO_MAIN
 int main() {
     Graph graph;
     graph.load();
     graph.displayMenu();
     return 0;
 }
+#endif
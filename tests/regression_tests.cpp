@@ -0,0 +1,471 @@
+// Regression cases for the routing engine. Each check prints PASS or FAIL; the exit code is
+// the number of failures, so ctest reports any of them.
+#define TRAFFIC_SIMULATION_NO_MAIN
+#include "../main.cpp"
+#include <cstdio>
+#include <fstream>
+
+int failures = 0;
+
+void check(bool passed, const char* name) {
+    cout << (passed ? "PASS " : "FAIL ") << name << '\n';
+    if (!passed) ++failures;
+}
+
+// A zero-weight loop X <-> Y feeds into the middle of the route A -> W -> T but is never
+// reached from A, so it must not make the count from A unbounded.
+void testZeroWeightCycleOffRoute() {
+    Graph graph;
+    uint32_t a = graph.addNode("A");
+    uint32_t w = graph.addNode("W");
+    uint32_t t = graph.addNode("T");
+    uint32_t x = graph.addNode("X");
+    uint32_t y = graph.addNode("Y");
+    graph.addEdge(a, w, 5);
+    graph.addEdge(w, t, 1);
+    graph.addEdge(x, y, 0);
+    graph.addEdge(y, x, 0);
+    graph.addEdge(y, w, 0);
+
+    check(graph.countRoutes(a, t, 10) == 1, "zero-weight cycle off the route leaves the count exact");
+    check(graph.countShortestRoutes(a, t) == 1, "zero-weight cycle off the route leaves the shortest count exact");
+    check(graph.countRoutes(x, t, 10) == COUNT_SATURATED, "zero-weight cycle on the route saturates the count");
+    check(graph.countRoutes(a, t, 5) == 0, "no route within a budget below the shortest route");
+}
+
+// The one-way loop A -> B -> C -> A looks connected if roads are taken as two-way, but
+// closing A -> B leaves A unable to reach B or C.
+void testOneWayClosureImpact() {
+    Graph graph;
+    uint32_t a = graph.addNode("A");
+    uint32_t b = graph.addNode("B");
+    uint32_t c = graph.addNode("C");
+    graph.addEdge(a, b, 1);
+    graph.addEdge(b, c, 1);
+    graph.addEdge(c, a, 1);
+    check(graph.closureImpact(a, b) == 2, "closing a one-way road cuts off everything behind it");
+    check(graph.closureImpact(b, c) == 2, "closing the next road cuts off the rest of the loop");
+
+    uint32_t d = graph.addNode("D");
+    graph.addEdge(a, d, 1);
+    graph.addEdge(d, b, 1);
+    check(graph.closureImpact(a, b) == 0, "a one-way detour keeps the road's end reachable");
+    check(graph.closureImpact(a, d) == 1, "closing the only road into the detour cuts it off");
+
+    graph.blockEdge("A", "B");
+    check(graph.closureImpact(a, b) == 0, "closing a closed road cuts nothing off");
+    check(graph.closureImpact(a, d) == 3, "the detour becomes the only way on once the road is closed");
+}
+
+// Every queue backend must find the same shortest route; BUCKET_QUEUE falls back to the heap
+// once a weight is too large for the buckets.
+void testQueueBackends() {
+    Graph graph;
+    uint32_t a = graph.addNode("A");
+    uint32_t b = graph.addNode("B");
+    uint32_t c = graph.addNode("C");
+    graph.addEdge(a, b, 4);
+    graph.addEdge(b, c, 3);
+    graph.addEdge(a, c, 9);
+    QueueBackend backends[] = {AUTO_QUEUE, HEAP_QUEUE, BUCKET_QUEUE};
+    bool same = true;
+    for (int i = 0; i < 3; ++i) {
+        RouteResult result = graph.route(RouteQuery(a, c, AVOID_BLOCKED, INT_MAX, DIJKSTRA, backends[i]));
+        same = same && result.found && result.cost == 7 && result.path.size() == 3;
+    }
+    check(same, "every queue backend finds the shortest route");
+
+    graph.addEdge(c, a, bucketQueueMaxWeight + 1);
+    RouteResult fallback = graph.route(RouteQuery(c, b, AVOID_BLOCKED, INT_MAX, DIJKSTRA, BUCKET_QUEUE));
+    check(fallback.found && fallback.cost == bucketQueueMaxWeight + 5, "the bucket queue falls back to the heap for heavy roads");
+}
+
+// ALT must agree with Dijkstra, also once a closure forces it off the road its landmarks
+// were measured on and after a weight change rebuilds them.
+void testAltMatchesDijkstra() {
+    Graph graph;
+    uint32_t a = graph.addNode("A");
+    uint32_t b = graph.addNode("B");
+    uint32_t c = graph.addNode("C");
+    uint32_t d = graph.addNode("D");
+    graph.addEdge(a, b, 2);
+    graph.addEdge(b, d, 2);
+    graph.addEdge(a, c, 3);
+    graph.addEdge(c, d, 4);
+    RouteResult alt = graph.route(RouteQuery(a, d, AVOID_BLOCKED, INT_MAX, ALT));
+    check(alt.found && alt.cost == 4 && alt.path.size() == 3, "ALT finds the shortest route");
+
+    graph.blockEdge("B", "D");
+    alt = graph.route(RouteQuery(a, d, AVOID_BLOCKED, INT_MAX, ALT));
+    RouteResult plain = graph.route(RouteQuery(a, d));
+    check(alt.found && alt.cost == 7 && plain.cost == 7, "ALT detours around a closed road");
+
+    graph.setWeight(a, *graph.getEdge(a, c), 1);
+    alt = graph.route(RouteQuery(a, d, AVOID_BLOCKED, INT_MAX, ALT));
+    check(alt.found && alt.cost == 5, "ALT sees a changed weight");
+}
+
+// The hierarchy answers routes that ignore blocks with Dijkstra's cost, and closing a road
+// doesn't rebuild it because it never looked at closures.
+void testHierarchyIgnoresClosures() {
+    Graph graph;
+    uint32_t a = graph.addNode("A");
+    uint32_t b = graph.addNode("B");
+    uint32_t c = graph.addNode("C");
+    uint32_t d = graph.addNode("D");
+    graph.addEdge(a, b, 1);
+    graph.addEdge(b, c, 1);
+    graph.addEdge(c, d, 1);
+    graph.addEdge(a, d, 5);
+    graph.addEdge(b, d, 2);
+    RouteResult fast = graph.route(RouteQuery(a, d, IGNORE_BLOCKED, INT_MAX, CONTRACTION_HIERARCHY));
+    RouteResult plain = graph.route(RouteQuery(a, d, IGNORE_BLOCKED));
+    check(fast.found && fast.cost == 3 && fast.cost == plain.cost, "the hierarchy matches Dijkstra");
+
+    int builds = graph.hierarchyBuilds;
+    graph.blockEdge("B", "D");
+    fast = graph.route(RouteQuery(a, d, IGNORE_BLOCKED, INT_MAX, CONTRACTION_HIERARCHY));
+    check(fast.cost == 3 && graph.hierarchyBuilds == builds, "a closure leaves the hierarchy as it is");
+    check(graph.countShortestRoutes(a, d, IGNORE_BLOCKED) == 2, "shortest routes are counted from the hierarchy's cost");
+
+    graph.setWeight(b, *graph.getEdge(b, d), 1);
+    fast = graph.route(RouteQuery(a, d, IGNORE_BLOCKED, INT_MAX, CONTRACTION_HIERARCHY));
+    check(fast.cost == 2 && graph.hierarchyBuilds == builds + 1, "a weight change rebuilds the hierarchy");
+}
+
+// A matrix query returns every pairwise cost and path; a repeated source copies its row and
+// an unknown target stays unreachable. routeBatch answers the same pairs the same way.
+void testDistanceMatrix() {
+    Graph graph;
+    uint32_t a = graph.addNode("A");
+    uint32_t b = graph.addNode("B");
+    uint32_t c = graph.addNode("C");
+    graph.addEdge(a, b, 2);
+    graph.addEdge(b, c, 3);
+    graph.addEdge(c, a, 1);
+    MatrixQuery query(AVOID_BLOCKED, true);
+    query.sources.pushBack(a);
+    query.sources.pushBack(c);
+    query.sources.pushBack(a);
+    query.targets.pushBack(c);
+    query.targets.pushBack(b);
+    query.targets.pushBack(NO_NODE);
+    DistanceMatrix matrix = graph.distanceMatrix(query);
+    check(matrix.cost(0, 0) == 5 && matrix.cost(0, 1) == 2 && matrix.cost(1, 1) == 3, "the matrix holds every pairwise cost");
+    check(matrix.path(0, 0).size() == 3 && matrix.path(1, 1).size() == 3, "the matrix holds every pairwise path");
+    check(matrix.cost(2, 0) == 5 && matrix.path(2, 0).size() == 3, "a repeated source copies its row");
+    check(matrix.cost(0, 2) == INT_MAX, "an unknown target is unreachable");
+
+    DynamicArray<RouteQuery> queries;
+    queries.pushBack(RouteQuery(a, c));
+    queries.pushBack(RouteQuery(a, b));
+    queries.pushBack(RouteQuery(a, c, AVOID_BLOCKED, 4));
+    DynamicArray<RouteResult> results = graph.routeBatch(queries);
+    check(results[0].cost == 5 && results[1].cost == 2 && results[1].path.size() == 2, "the batch reads its costs and paths off matrix rows");
+    check(!results[2].found, "the batch still honours each query's maximum cost");
+}
+
+// A road between intersections the index already connects keeps the index; a road that
+// closes a loop merges components, so the index is rebuilt and answers the new pair.
+void testReachabilityAfterNewRoads() {
+    Graph graph;
+    uint32_t a = graph.addNode("A");
+    uint32_t b = graph.addNode("B");
+    uint32_t c = graph.addNode("C");
+    graph.addEdge(a, b, 1);
+    graph.addEdge(b, c, 1);
+    check(!graph.mayReach(c, a), "nothing leads back to the start");
+
+    graph.addEdge(a, c, 5);
+    check(!graph.reachabilityStale[AVOID_BLOCKED], "a shortcut between connected intersections keeps the index");
+    graph.addEdge(c, a, 1);
+    check(graph.reachabilityStale[AVOID_BLOCKED], "a road closing a loop invalidates the index");
+    check(graph.mayReach(c, a) && graph.route(RouteQuery(c, b)).cost == 2, "the rebuilt index lets the new route through");
+}
+
+// Closing a road the cached root can't reach keeps its dominator tree; closing one it does
+// reach rebuilds the tree, and the impact reflects the closure.
+void testClosureImpactKeepsTree() {
+    Graph graph;
+    uint32_t a = graph.addNode("A");
+    uint32_t b = graph.addNode("B");
+    uint32_t c = graph.addNode("C");
+    uint32_t x = graph.addNode("X");
+    graph.addEdge(a, b, 1);
+    graph.addEdge(a, c, 1);
+    graph.addEdge(c, b, 1);
+    graph.addEdge(x, a, 1);
+    check(graph.closureImpact(a, b) == 0, "a detour through C keeps B reachable");
+
+    graph.blockEdge("X", "A");
+    check(!graph.dominatorsStale, "closing a road the root can't reach keeps the tree");
+    graph.blockEdge("C", "B");
+    check(graph.closureImpact(a, b) == 1, "closing the detour makes A -> B the only way to B");
+}
+
+// decreaseKey reorders the heap, and emergency vehicles are listed in the order the file
+// gives them while the heap still knows each one's priority.
+void testEmergencyLoadOrder() {
+    NodeHeap<> heap;
+    heap.insert(1, 30);
+    heap.insert(2, 20);
+    heap.insert(3, 10);
+    heap.decreaseKey(1, 5);
+    heap.insert(2, 40);
+    check(heap.priorityOf(2) == 20 && heap.priorityOf(7) == INT_MAX, "insert never raises a priority");
+    int first = heap.extractMin().id;
+    int second = heap.extractMin().id;
+    check(first == 1 && second == 3 && heap.extractMin().id == 2 && heap.isEmpty(), "decreaseKey moves an id to the front");
+
+    Graph graph;
+    graph.addNode("A");
+    graph.addNode("B");
+    const char* file = "regression_emergency.csv";
+    ofstream out(file);
+    out << "ID,Start,End,Priority\nEV1,A,B,Low\nEV2,B,A,High\nEV3,A,B,Medium\n";
+    out.close();
+    graph.loadEmergencyVehicles(file);
+    remove(file);
+    DynamicArray<Vehicles>& arrivals = graph.emergencyArrivals;
+    check(arrivals.size() == 3 && arrivals[0].id == "EV1" && arrivals[1].id == "EV2" && arrivals[2].id == "EV3",
+          "emergency vehicles are listed in load order");
+    check(graph.emergencyVehicles.priorityOf(arrivals[0]) == 2 && graph.emergencyVehicles.priorityOf(arrivals[1]) == 0,
+          "the heap keeps each emergency vehicle's priority");
+}
+
+// Builds a rows x columns grid of two-way streets named R<row>C<column>, with weights that
+// vary so shortest routes aren't all ties.
+void buildGrid(Graph& graph, int rows, int columns) {
+    for (int r = 0; r < rows; ++r) {
+        for (int c = 0; c < columns; ++c) {
+            graph.addNode("R" + to_string(r) + "C" + to_string(c));
+        }
+    }
+    for (int r = 0; r < rows; ++r) {
+        for (int c = 0; c < columns; ++c) {
+            uint32_t u = r * columns + c;
+            if (c + 1 < columns) {
+                graph.addEdge(u, u + 1, 1 + (r * 7 + c * 3) % 5);
+                graph.addEdge(u + 1, u, 1 + (r * 5 + c * 11) % 5);
+            }
+            if (r + 1 < rows) {
+                graph.addEdge(u, u + columns, 1 + (r * 3 + c * 7) % 5);
+                graph.addEdge(u + columns, u, 1 + (r * 11 + c * 5) % 5);
+            }
+        }
+    }
+}
+
+// True if the overlay agrees with Dijkstra on every pair of intersections.
+bool overlayMatchesDijkstra(Graph& graph) {
+    for (int s = 0; s < graph.nodes.size(); ++s) {
+        for (int t = 0; t < graph.nodes.size(); ++t) {
+            RouteResult overlay = graph.route(RouteQuery(s, t, AVOID_BLOCKED, INT_MAX, CUSTOMIZABLE_OVERLAY));
+            RouteResult plain = graph.route(RouteQuery(s, t));
+            if (overlay.found != plain.found || overlay.cost != plain.cost) return false;
+        }
+    }
+    return true;
+}
+
+// The overlay only recomputes the cells a changed road lies in, so its routes must still
+// match Dijkstra after closures, reopenings and weight changes.
+void testOverlayAfterRoadChanges() {
+    Graph graph;
+    buildGrid(graph, 12, 12);  // Large enough for several cells of 64
+    check(overlayMatchesDijkstra(graph), "the overlay matches Dijkstra");
+    graph.blockEdge("R5C5", "R5C6");
+    graph.blockEdge("R6C6", "R5C6");
+    graph.blockEdge("R0C1", "R0C0");
+    check(overlayMatchesDijkstra(graph), "the overlay matches Dijkstra after closures");
+    uint32_t u = graph.indexOf("R5C5");
+    graph.setWeight(0, *graph.getEdge(0, 1), 9);
+    graph.setBlocked(u, *graph.getEdge(u, u + 1), false);
+    check(overlayMatchesDijkstra(graph), "the overlay matches Dijkstra after a reopening and a weight change");
+}
+
+// True if a tree's distances match Dijkstra and every parent lies on a shortest route.
+bool treeMatchesDijkstra(Graph& graph, ShortestPathTree& tree) {
+    for (int t = 0; t < graph.nodes.size(); ++t) {
+        RouteResult plain = graph.route(RouteQuery(tree.source, t));
+        if (tree.distances[t] != plain.cost) return false;
+        uint32_t parent = tree.parents[t];
+        if (parent == NO_NODE) {
+            if (t != (int)tree.source && plain.found) return false;
+        } else if (tree.distances[parent] + graph.getEdge(parent, t)->weight != tree.distances[t]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Delta-stepping must give Dijkstra's distances whatever the bucket width, also with
+// zero-weight roads and with frontiers large enough to be split over the pool.
+void testDeltaSteppingDistances() {
+    Graph graph;
+    buildGrid(graph, 40, 40);
+    graph.addEdge(0, 41, 0);
+    graph.addEdge(41, 0, 0);
+    graph.blockEdge("R1C1", "R1C2");
+    CSRGraph& snapshot = graph.snapshot();
+    int deltas[] = {1, 3, 1000};
+    bool same = true;
+    for (int i = 0; i < 3; ++i) {
+        DeltaStepping search(snapshot, false, deltas[i]);
+        ShortestPathTree tree = search.run(0);
+        same = same && treeMatchesDijkstra(graph, tree);
+    }
+    check(same, "delta-stepping matches Dijkstra for every bucket width");
+}
+
+// A watched tree is repaired in place after closures, reopenings and weight changes, and
+// must end up where a fresh search would.
+void testWatchedTreeRepair() {
+    Graph graph;
+    buildGrid(graph, 10, 10);
+    int handle = graph.watchSource(0);
+    check(treeMatchesDijkstra(graph, graph.sourceTree(handle)), "a watched tree starts out exact");
+
+    graph.blockEdge("R0C0", "R0C1");
+    graph.blockEdge("R4C4", "R4C5");
+    check(treeMatchesDijkstra(graph, graph.sourceTree(handle)), "the watched tree is repaired after closures");
+    check(!graph.sourceTreesStale, "closures repair the watched tree instead of rebuilding it");
+
+    graph.setBlocked(0, *graph.getEdge(0, 1), false);
+    graph.setWeight(10, *graph.getEdge(10, 20), 1);
+    graph.setWeight(1, *graph.getEdge(1, 2), 5);
+    check(treeMatchesDijkstra(graph, graph.sourceTree(handle)), "the watched tree is repaired after a reopening and weight changes");
+}
+
+// Every entry must come out of the wheel in the advance that passes its time, whether it was
+// filed on level 0, cascaded down from a higher level or waited beyond the wheel's span.
+void testTimingWheelDueTimes() {
+    int times[] = {1, 63, 64, 65, 130, 4095, 4097, 300000, TimingWheel::span + 5};
+    int count = sizeof(times) / sizeof(times[0]);
+    TimingWheel wheel;
+    wheel.reset(0);
+    for (int i = 0; i < count; ++i) {
+        wheel.schedule(i, times[i]);
+    }
+    int steps[] = {1, 62, 64, 66, 200, 4096, 5000, 299999, 300000, TimingWheel::span + 4, TimingWheel::span + 10};
+    bool onTime = true;
+    int seen = 0;
+    int before = 0;
+    for (int s = 0; s < (int)(sizeof(steps) / sizeof(steps[0])); ++s) {
+        DynamicArray<uint32_t> due;
+        wheel.advance(steps[s], due);
+        for (int i = 0; i < due.size(); ++i) {
+            int time = times[due[i]];
+            onTime = onTime && time > before && time <= steps[s];
+        }
+        seen += due.size();
+        before = steps[s];
+    }
+    check(onTime && seen == count && wheel.size == 0, "timing wheel entries fall due in the advance that passes their time");
+}
+
+// Builds a small network with exactly five loopless routes from A to E: three of cost 4
+// (A-B-D-E, A-C-D-E, A-B-C-D-E) and two of cost 6 (A-C-E, A-B-C-E).
+void buildRouteFan(Graph& graph) {
+    uint32_t a = graph.addNode("A");
+    uint32_t b = graph.addNode("B");
+    uint32_t c = graph.addNode("C");
+    uint32_t d = graph.addNode("D");
+    uint32_t e = graph.addNode("E");
+    graph.addEdge(a, b, 1);
+    graph.addEdge(a, c, 2);
+    graph.addEdge(b, c, 1);
+    graph.addEdge(b, d, 2);
+    graph.addEdge(c, d, 1);
+    graph.addEdge(d, e, 1);
+    graph.addEdge(c, e, 4);
+    graph.addEdge(d, b, 1);
+}
+
+// True if a path visits no intersection twice.
+bool loopless(DynamicArray<uint32_t>& path) {
+    for (int i = 0; i < path.size(); ++i) {
+        for (int j = i + 1; j < path.size(); ++j) {
+            if (path[i] == path[j]) return false;
+        }
+    }
+    return true;
+}
+
+// True if two paths visit the same intersections in the same order.
+bool samePath(DynamicArray<uint32_t>& first, DynamicArray<uint32_t>& second) {
+    if (first.size() != second.size()) return false;
+    for (int i = 0; i < first.size(); ++i) {
+        if (first[i] != second[i]) return false;
+    }
+    return true;
+}
+
+// Yen's algorithm returns the k cheapest loopless routes, cheapest first, each once, and
+// all of them when there are fewer than k.
+void testKShortestPaths() {
+    Graph graph;
+    buildRouteFan(graph);
+    uint32_t a = graph.indexOf("A");
+    uint32_t e = graph.indexOf("E");
+    DynamicArray<RouteResult> three = graph.kShortestPaths(a, e, 3);
+    check(three.size() == 3 && three[0].cost == 4 && three[1].cost == 4 && three[2].cost == 4,
+          "the three cheapest routes all cost 4");
+
+    DynamicArray<RouteResult> all = graph.kShortestPaths(a, e, 10);
+    bool ordered = all.size() == 5;
+    for (int i = 0; ordered && i < all.size(); ++i) {
+        ordered = loopless(all[i].path) && (i == 0 || all[i - 1].cost <= all[i].cost);
+        for (int j = 0; ordered && j < i; ++j) {
+            ordered = !samePath(all[i].path, all[j].path);
+        }
+    }
+    check(ordered && all[4].cost == 6, "asking for more routes than exist returns each loopless route once, cheapest first");
+}
+
+// Lists the routes an enumerator yields and returns how many there were; costs gets the
+// largest cost and hops the most roads seen.
+int drain(PathEnumerator paths, int& costs, int& hops) {
+    int count = 0;
+    costs = 0;
+    hops = 0;
+    while (paths.next()) {
+        ++count;
+        if (paths.cost > costs) costs = paths.cost;
+        if (paths.path.size() - 1 > hops) hops = paths.path.size() - 1;
+    }
+    return count;
+}
+
+// The streaming enumerator lists every loopless route and honours each of its limits.
+void testPathEnumerationLimits() {
+    Graph graph;
+    buildRouteFan(graph);
+    uint32_t a = graph.indexOf("A");
+    uint32_t e = graph.indexOf("E");
+    int costs, hops;
+    check(drain(graph.enumeratePaths(a, e, AVOID_BLOCKED), costs, hops) == 5, "every loopless route is listed");
+    check(drain(graph.enumeratePaths(a, e, AVOID_BLOCKED, 5), costs, hops) == 3 && costs == 4, "the cost limit drops dearer routes");
+    check(drain(graph.enumeratePaths(a, e, AVOID_BLOCKED, INT_MAX, 3), costs, hops) == 4 && hops == 3, "the road limit drops longer routes");
+    check(drain(graph.enumeratePaths(a, e, AVOID_BLOCKED, INT_MAX, INT_MAX, 2), costs, hops) == 2, "the count limit stops the listing");
+    check(drain(graph.enumeratePaths(a, a, AVOID_BLOCKED), costs, hops) == 1 && hops == 0, "a node reaches itself by the empty route");
+}
+
+int main() {
+    testZeroWeightCycleOffRoute();
+    testOneWayClosureImpact();
+    testQueueBackends();
+    testAltMatchesDijkstra();
+    testHierarchyIgnoresClosures();
+    testDistanceMatrix();
+    testReachabilityAfterNewRoads();
+    testClosureImpactKeepsTree();
+    testEmergencyLoadOrder();
+    testOverlayAfterRoadChanges();
+    testDeltaSteppingDistances();
+    testWatchedTreeRepair();
+    testTimingWheelDueTimes();
+    testKShortestPaths();
+    testPathEnumerationLimits();
+    return failures;
+}